@@ -0,0 +1,383 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "../maze_generator/maze.h"
+#include "../maze_generator/threading.h"
+#include "../path_finder/path.h"
+
+using std::cout;
+using std::cerr;
+using std::ostream;
+using namespace std::chrono;
+
+/**
+ * Benchmark harness for the maze generators and path searches
+ * Every case is warmed up, then run repeatedly and summarized as the min,
+ * median and 99th percentile time. Results are written as CSV or JSON so runs
+ * can be compared between releases, progress goes to stderr.
+ *
+ * usage: bench [options]
+ *     --algorithms a,b,...   generators to sweep (default: all)
+ *     --sizes n,...          square maze sizes in cells (default: 256,1024)
+ *     --threads n,...        thread counts for the parallel generators and tiles, 0 is one per
+ *                            hardware thread (default: 1,0)
+ *     --tiles n,...          tile sizes to generate with, 0 is untiled (default: 0)
+ *     --mazes grid,packed    maze representations to generate into (default: grid)
+ *     --runs n               timed runs per generator case (default: 5)
+ *     --warmup n             untimed runs before them (default: 1)
+ *     --searches a,b,...     path searches to time, none to skip (default: a-star,bidirectional,corridor)
+ *     --heuristic h          heuristic for the searches (default: manhattan)
+ *     --solve-algorithm a    generator of the mazes searched (default: kruskal)
+ *     --queries n            timed queries per search case (default: 200)
+ *     --seed n               seed of every maze, so runs are reproducible (default: 1)
+ *     --bulk n               also time jobs of n mazes of the algorithm mix on every thread
+ *                            count, with sizes as above (default: 0, skipped)
+ *     --format csv|json      output format (default: csv)
+ *     --output file          write results to a file instead of stdout
+ */
+
+struct bench_result {
+    string kind; // generate, search or bulk
+    string algorithm; // generator, the search and the maze generator it ran on, or the bulk mix
+    string maze;
+    size_t width;
+    size_t height;
+    size_t threads;
+    size_t tile_size;
+    size_t runs;
+    double min_ms;
+    double median_ms;
+    double p99_ms;
+    double throughput; // cells per second for generators, queries per second for searches, mazes per second for bulk
+    size_t peak_rss_kb; // generators only
+    double expanded; // mean cells expanded per query, searches only
+};
+
+struct bench_options {
+    vector<string> algorithms;
+    vector<size_t> sizes;
+    vector<size_t> threads;
+    vector<size_t> tiles;
+    vector<string> mazes;
+    size_t runs;
+    size_t warmup;
+    vector<string> searches;
+    string heuristic;
+    string solve_algorithm;
+    size_t queries;
+    uint64_t seed;
+    size_t bulk;
+    string format;
+    string output;
+};
+
+static vector<string> split(const string& list) {
+    vector<string> items;
+    std::stringstream stream(list);
+    string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+static vector<size_t> split_numbers(const string& list) {
+    vector<size_t> numbers;
+    for (const string& item : split(list)) numbers.push_back(std::stoul(item));
+    return numbers;
+}
+
+/**
+ * Reset the peak resident set size of the process, where the kernel allows it
+ * (Linux 4.0 and later), so the peak can be read per case
+ * Freed memory is returned to the system first, or the mazes of earlier cases
+ * would still count towards it
+ */
+static void reset_peak_rss() {
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs.is_open()) clear_refs << "5";
+}
+
+/**
+ * Peak resident set size in KiB since the last reset, or since the start of
+ * the process if the peak cannot be reset
+ */
+static size_t peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    string line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0) return std::stoul(line.substr(6));
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t) usage.ru_maxrss;
+}
+
+// nearest-rank percentile of sorted samples
+static double percentile(const vector<double>& sorted, double p) {
+    size_t rank = (size_t) std::ceil(p / 100 * sorted.size());
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void summarize(vector<double> samples, bench_result& result) {
+    std::sort(samples.begin(), samples.end());
+    result.runs = samples.size();
+    result.min_ms = samples.front();
+    result.median_ms = percentile(samples, 50);
+    result.p99_ms = percentile(samples, 99);
+}
+
+static bool parallel_algorithm(const string& algorithm) {
+    return algorithm == "kruskal-parallel" || algorithm == "recursive-division";
+}
+
+template <class Maze>
+static unique_ptr<Maze> generate_bench_maze(size_t size, const string& algorithm, size_t threads,
+    size_t tile_size, uint64_t seed);
+
+template <>
+unique_ptr<MazeGrid> generate_bench_maze<MazeGrid>(size_t size, const string& algorithm, size_t threads,
+    size_t tile_size, uint64_t seed) {
+    return generate_maze(size, size, algorithm, 0, 0, true, false, threads, tile_size, seed);
+}
+
+template <>
+unique_ptr<PackedMaze> generate_bench_maze<PackedMaze>(size_t size, const string& algorithm, size_t threads,
+    size_t tile_size, uint64_t seed) {
+    return generate_packed_maze(size, size, algorithm, 0, 0, true, threads, tile_size, seed);
+}
+
+/**
+ * Time one generator case, allocation included, keeping the highest peak RSS of its runs
+ */
+template <class Maze>
+static bool bench_generator(const bench_options& options, const string& algorithm, const string& maze_name,
+    size_t size, size_t threads, size_t tile_size, bench_result& result) {
+    vector<double> samples;
+    size_t peak = 0;
+    for (size_t run = 0; run < options.warmup + options.runs; ++run) {
+        reset_peak_rss();
+        auto start = steady_clock::now();
+        unique_ptr<Maze> maze = generate_bench_maze<Maze>(size, algorithm, threads, tile_size, options.seed);
+        auto stop = steady_clock::now();
+        if (!maze) return false;
+        if (run < options.warmup) continue;
+        samples.push_back(duration_cast<nanoseconds>(stop - start).count() / 1e6);
+        peak = std::max(peak, peak_rss_kb());
+    }
+    result = bench_result{"generate", algorithm, maze_name, size, size, threads, tile_size, 0, 0, 0, 0, 0, peak, 0};
+    summarize(samples, result);
+    result.throughput = size * size / (result.median_ms / 1e3);
+    return true;
+}
+
+/**
+ * Time single queries of one search between random cells of one maze
+ */
+static void bench_search(const bench_options& options, const PackedMaze& maze, const string& search,
+    size_t size, bench_result& result) {
+    std::mt19937 gen(1); // the same queries for every search
+    std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+    PathSearchContext<PackedMaze> context(maze);
+    vector<size_t> path;
+    size_t warmup = std::min(options.queries, (size_t) 10);
+    for (size_t q = 0; q < warmup; ++q)
+        context.find_path(coordinate(gen), coordinate(gen), coordinate(gen), coordinate(gen), path,
+            options.heuristic, search);
+
+    vector<double> samples;
+    double expanded = 0;
+    for (size_t q = 0; q < options.queries; ++q) {
+        size_t sx = coordinate(gen), sy = coordinate(gen), ex = coordinate(gen), ey = coordinate(gen);
+        auto start = steady_clock::now();
+        context.find_path(sx, sy, ex, ey, path, options.heuristic, search);
+        auto stop = steady_clock::now();
+        samples.push_back(duration_cast<nanoseconds>(stop - start).count() / 1e6);
+        expanded += context.expanded();
+    }
+    result = bench_result{"search", search + "/" + options.solve_algorithm, "packed", size, size, 1, 0, 0, 0, 0, 0, 0, 0,
+        expanded / options.queries};
+    summarize(samples, result);
+    double total_ms = 0;
+    for (double sample : samples) total_ms += sample;
+    result.throughput = samples.size() / (total_ms / 1e3);
+}
+
+/**
+ * Time jobs of many mazes through the bulk generator, without writing them
+ */
+static bool bench_bulk(const bench_options& options, size_t size, size_t threads, bench_result& result) {
+    bulk_options job = default_bulk_options(options.bulk, size);
+    job.algorithms = options.algorithms;
+    job.seed = options.seed;
+    job.threads = threads;
+    vector<double> samples;
+    size_t peak = 0;
+    for (size_t run = 0; run < options.warmup + options.runs; ++run) {
+        reset_peak_rss();
+        bulk_stats stats;
+        if (!generate_bulk_mazes(job, &stats)) return false;
+        if (run < options.warmup) continue;
+        samples.push_back(stats.seconds * 1e3);
+        peak = std::max(peak, peak_rss_kb());
+    }
+    string mix;
+    for (const string& algorithm : options.algorithms) mix += (mix.empty() ? "" : "+") + algorithm;
+    result = bench_result{"bulk", mix, "packed", size, size, threads, 0, 0, 0, 0, 0, 0, peak, 0};
+    summarize(samples, result);
+    result.throughput = options.bulk / (result.median_ms / 1e3);
+    return true;
+}
+
+static void write_csv(ostream& out, const vector<bench_result>& results) {
+    out << "kind,algorithm,maze,width,height,threads,tile_size,runs,min_ms,median_ms,p99_ms,throughput,peak_rss_kb,expanded\n";
+    for (const bench_result& r : results)
+        out << r.kind << "," << r.algorithm << "," << r.maze << "," << r.width << "," << r.height << ","
+            << r.threads << "," << r.tile_size << "," << r.runs << "," << r.min_ms << "," << r.median_ms << "," << r.p99_ms << ","
+            << r.throughput << "," << r.peak_rss_kb << "," << r.expanded << "\n";
+}
+
+static void write_json(ostream& out, const vector<bench_result>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result& r = results[i];
+        out << "  {\"kind\": \"" << r.kind << "\", \"algorithm\": \"" << r.algorithm << "\", \"maze\": \""
+            << r.maze << "\", \"width\": " << r.width << ", \"height\": " << r.height << ", \"threads\": "
+            << r.threads << ", \"tile_size\": " << r.tile_size << ", \"runs\": " << r.runs << ", \"min_ms\": " << r.min_ms << ", \"median_ms\": "
+            << r.median_ms << ", \"p99_ms\": " << r.p99_ms << ", \"throughput\": " << r.throughput
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb << ", \"expanded\": " << r.expanded << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "]\n";
+}
+
+static int usage(const char* program) {
+    cerr << "usage: " << program << " [--algorithms a,b] [--sizes n,m] [--threads n,m] [--tiles n,m]\n"
+        << "    [--mazes grid,packed] [--runs n] [--warmup n] [--searches a,b|none] [--heuristic h] [--solve-algorithm a]\n"
+        << "    [--queries n] [--seed n] [--bulk n] [--format csv|json] [--output file]\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    bench_options options;
+    options.algorithms = split("dfs,kruskal,kruskal-parallel,prim,aldous-broder,wilson,aldous-broder-wilson,"
+        "recursive-division,eller,sidewinder,binary-tree");
+    options.sizes = {256, 1024};
+    options.threads = {1, 0};
+    options.tiles = {0};
+    options.mazes = {"grid"};
+    options.runs = 5;
+    options.warmup = 1;
+    options.searches = split("a-star,bidirectional,corridor");
+    options.heuristic = "manhattan";
+    options.solve_algorithm = "kruskal";
+    options.queries = 200;
+    options.seed = 1;
+    options.bulk = 0;
+    options.format = "csv";
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) return usage(argv[0]);
+        string value = argv[++i];
+        try {
+            if (option == "--algorithms") options.algorithms = split(value);
+            else if (option == "--sizes") options.sizes = split_numbers(value);
+            else if (option == "--threads") options.threads = split_numbers(value);
+            else if (option == "--tiles") options.tiles = split_numbers(value);
+            else if (option == "--mazes") options.mazes = split(value);
+            else if (option == "--runs") options.runs = std::stoul(value);
+            else if (option == "--warmup") options.warmup = std::stoul(value);
+            else if (option == "--searches") options.searches = value == "none" ? vector<string>() : split(value);
+            else if (option == "--heuristic") options.heuristic = value;
+            else if (option == "--solve-algorithm") options.solve_algorithm = value;
+            else if (option == "--queries") options.queries = std::stoul(value);
+            else if (option == "--seed") options.seed = std::stoull(value);
+            else if (option == "--bulk") options.bulk = std::stoul(value);
+            else if (option == "--format") options.format = value;
+            else if (option == "--output") options.output = value;
+            else return usage(argv[0]);
+        }
+        catch (const std::exception&) {
+            return usage(argv[0]);
+        }
+    }
+    if (options.runs == 0 || options.queries == 0 || (options.format != "csv" && options.format != "json"))
+        return usage(argv[0]);
+
+    // thread counts are resolved and deduplicated, so 0 does not repeat the hardware count
+    vector<size_t> thread_counts;
+    for (size_t threads : options.threads) {
+        size_t resolved = resolve_thread_count(threads);
+        if (std::find(thread_counts.begin(), thread_counts.end(), resolved) == thread_counts.end())
+            thread_counts.push_back(resolved);
+    }
+
+    vector<bench_result> results;
+    for (const string& algorithm : options.algorithms)
+        for (size_t size : options.sizes)
+            for (const string& maze : options.mazes)
+                for (size_t tile_size : options.tiles)
+                    for (size_t threads : thread_counts) {
+                        // only parallel algorithms and tiles use more than one thread
+                        bool threaded = parallel_algorithm(algorithm) || tile_size > 0;
+                        if (!threaded && threads != thread_counts.front()) continue;
+                        if (!threaded) threads = 1;
+                        cerr << "generate " << algorithm << " " << size << "x" << size << " " << maze << " "
+                            << threads << " threads";
+                        if (tile_size > 0) cerr << " " << tile_size << " cell tiles";
+                        cerr << "\n";
+                        bench_result result;
+                        bool valid = maze == "packed"
+                            ? bench_generator<PackedMaze>(options, algorithm, maze, size, threads, tile_size, result)
+                            : maze == "grid"
+                            ? bench_generator<MazeGrid>(options, algorithm, maze, size, threads, tile_size, result)
+                            : false;
+                        if (!valid) {
+                            cerr << "ERROR: unable to generate " << algorithm << " into " << maze << "!\n";
+                            return 1;
+                        }
+                        results.push_back(result);
+                    }
+
+    for (size_t size : options.searches.empty() ? vector<size_t>() : options.sizes) {
+        auto maze = generate_packed_maze(size, size, options.solve_algorithm, 0, 0, true, 0, 0, options.seed);
+        if (!maze) return 1;
+        for (const string& search : options.searches) {
+            cerr << "search " << search << " " << size << "x" << size << "\n";
+            bench_result result;
+            bench_search(options, *maze, search, size, result);
+            results.push_back(result);
+        }
+    }
+
+    for (size_t size : options.bulk > 0 ? options.sizes : vector<size_t>())
+        for (size_t threads : thread_counts) {
+            cerr << "bulk " << options.bulk << " mazes " << size << "x" << size << " " << threads << " threads\n";
+            bench_result result;
+            if (!bench_bulk(options, size, threads, result)) return 1;
+            results.push_back(result);
+        }
+
+    if (options.output.empty()) {
+        if (options.format == "json") write_json(cout, results);
+        else write_csv(cout, results);
+        return 0;
+    }
+    std::ofstream outfile(options.output);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        return 1;
+    }
+    if (options.format == "json") write_json(outfile, results);
+    else write_csv(outfile, results);
+}
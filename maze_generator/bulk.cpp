@@ -0,0 +1,79 @@
+#include <iostream>
+#include <sstream>
+#include "maze.h"
+
+using std::cout;
+using std::cerr;
+
+/**
+ * Generate many mazes at once into a maze archive or sharded archives
+ * Each maze is a record of the binary maze file format with its own size,
+ * algorithm and seed, see map_maze_archive.
+ *
+ * usage: bulk <count> <output> [options]
+ *     --size n               square mazes of n cells (default: 32)
+ *     --width a[-b]          widths drawn from a to b cells, overrides --size
+ *     --height a[-b]         heights drawn from a to b cells, overrides --size
+ *     --algorithms a[:w],... algorithm mix with optional weights (default: kruskal)
+ *     --seed n               base seed of the job (default: 1)
+ *     --threads n            generating threads, 0 is one per hardware thread (default: 0)
+ *     --shards n             split into output.0 to output.<n-1> (default: one archive)
+ *     --queue n              finished mazes that may wait for the writer (default: 2 per thread)
+ */
+
+static int usage(const char* program) {
+    cerr << "usage: " << program << " <count> <output> [--size n] [--width a-b] [--height a-b]\n"
+        << "    [--algorithms a:w,b:w] [--seed n] [--threads n] [--shards n] [--queue n]\n";
+    return 1;
+}
+
+// a single number or an inclusive range a-b
+static void parse_range(const string& value, size_t& low, size_t& high) {
+    size_t dash = value.find('-');
+    low = std::stoul(value.substr(0, dash));
+    high = dash == string::npos ? low : std::stoul(value.substr(dash + 1));
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) return usage(argv[0]);
+    bulk_options options = default_bulk_options(0, 32, "kruskal", argv[2]);
+    try {
+        options.count = std::stoul(argv[1]);
+        for (int i = 3; i < argc; ++i) {
+            string option = argv[i];
+            if (i + 1 >= argc) return usage(argv[0]);
+            string value = argv[++i];
+            if (option == "--size") parse_range(value, options.min_width, options.max_width),
+                parse_range(value, options.min_height, options.max_height);
+            else if (option == "--width") parse_range(value, options.min_width, options.max_width);
+            else if (option == "--height") parse_range(value, options.min_height, options.max_height);
+            else if (option == "--algorithms") {
+                options.algorithms.clear();
+                options.weights.clear();
+                std::stringstream list(value);
+                string item;
+                bool weighted = false;
+                while (std::getline(list, item, ',')) {
+                    size_t colon = item.find(':');
+                    options.algorithms.push_back(item.substr(0, colon));
+                    options.weights.push_back(colon == string::npos ? 1 : std::stod(item.substr(colon + 1)));
+                    weighted = weighted || colon != string::npos;
+                }
+                if (!weighted) options.weights.clear();
+            }
+            else if (option == "--seed") options.seed = std::stoull(value);
+            else if (option == "--threads") options.threads = std::stoul(value);
+            else if (option == "--shards") options.shards = std::stoul(value);
+            else if (option == "--queue") options.queue_depth = std::stoul(value);
+            else return usage(argv[0]);
+        }
+    }
+    catch (const std::exception&) {
+        return usage(argv[0]);
+    }
+
+    bulk_stats stats;
+    if (!generate_bulk_mazes(options, &stats)) return 1;
+    cout << stats.mazes << " mazes, " << stats.cells << " cells, " << stats.bytes << " bytes in "
+        << stats.seconds << " s: " << stats.mazes / stats.seconds << " mazes/s\n";
+}
@@ -0,0 +1,78 @@
+#ifndef CONCURRENT_DISJOINT_SET_H
+#define CONCURRENT_DISJOINT_SET_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+
+using std::size_t;
+using std::unique_ptr;
+
+/**
+ * Lock-free disjoint set forest over the elements 0..size-1 for concurrent use
+ * Parents are atomics, finds halve paths with a CAS and unions link roots by
+ * index with a CAS, retrying if another thread linked the root first
+ */
+template <class Index = std::uint32_t>
+class concurrent_disjoint_set {
+    private:
+        size_t count;
+        unique_ptr<std::atomic<Index>[]> parents;
+    public:
+        concurrent_disjoint_set(size_t size) : count(size), parents(new std::atomic<Index>[size]) {
+            for (size_t i = 0; i < size; ++i) parents[i].store((Index) i, std::memory_order_relaxed);
+        }
+        size_t size() const {
+            return count;
+        }
+        /**
+         * Get the root of the set containing an element
+         */
+        Index find(Index index) {
+            while (true) {
+                Index parent = parents[index].load(std::memory_order_acquire);
+                if (parent == index) return index;
+                Index grandparent = parents[parent].load(std::memory_order_acquire);
+                if (grandparent != parent) // path halving, skipped if someone else moved it
+                    parents[index].compare_exchange_weak(parent, grandparent, std::memory_order_release,
+                        std::memory_order_relaxed);
+                index = grandparent;
+            }
+        }
+        bool same_set(Index a, Index b) {
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b) return true;
+                // a is still a root, so the two sets were different at this point
+                if (parents[a].load(std::memory_order_acquire) == a) return false;
+            }
+        }
+        /**
+         * Merge the sets containing two elements, linking the root with the
+         * smaller index under the other
+         *
+         * @return whether this call merged the two sets
+         */
+        bool union_sets(Index a, Index b) {
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b) return false;
+                if (a > b) std::swap(a, b);
+                Index expected = a;
+                if (parents[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel))
+                    return true;
+            }
+        }
+        /**
+         * Point a root at a new parent without a CAS, for callers that already
+         * have exclusive ownership of the root
+         */
+        void link(Index root, Index parent) {
+            parents[root].store(parent, std::memory_order_release);
+        }
+};
+
+#endif
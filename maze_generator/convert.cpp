@@ -0,0 +1,47 @@
+#include <iostream>
+#include <cstring>
+#include "maze.h"
+
+using std::cout;
+using std::cerr;
+
+/**
+ * Convert mazes between the text formats and the binary maze file format
+ * The input format is detected from the file header.
+ *
+ * usage: convert <input> <output> [packed|binary|display]
+ *     packed   binary maze file (default)
+ *     binary   legacy text of 0s and 1s
+ *     display  legacy text of blocks and spaces
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 4) {
+        cerr << "usage: " << argv[0] << " <input> <output> [packed|binary|display]\n";
+        return 1;
+    }
+    string input = argv[1], output = argv[2], format = argc == 4 ? argv[3] : "packed";
+    if (format != "packed" && format != "binary" && format != "display") {
+        cerr << "ERROR: Invalid output format!\n";
+        return 1;
+    }
+
+    MazeFileHeader header;
+    unique_ptr<PackedMaze> maze;
+    string algorithm;
+    uint64_t seed = 0;
+    if (is_maze_file(input)) {
+        maze = map_maze_file(input, &header);
+        if (!maze) return 1;
+        algorithm = string(header.algorithm, strnlen(header.algorithm, sizeof(header.algorithm)));
+        seed = header.seed;
+    }
+    else {
+        unique_ptr<MazeGrid> grid = load_maze(input);
+        if (!grid) return 1;
+        maze.reset(new PackedMaze(*grid));
+    }
+
+    if (format == "packed") save_maze_file(*maze, output, algorithm, seed);
+    else save_maze(*maze, output, format == "binary");
+    cout << input << " -> " << output << ": " << maze->cell_width() << "x" << maze->cell_height() << "\n";
+}
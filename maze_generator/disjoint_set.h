@@ -0,0 +1,106 @@
+#ifndef DISJOINT_SET_H
+#define DISJOINT_SET_H
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <iostream>
+
+using std::cerr;
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+
+/**
+ * Index-only disjoint set forest over the elements 0..size-1
+ * Parents are kept in one flat array of Index (32-bit by default) and ranks in
+ * a byte array, finds use iterative path halving and unions are by rank
+ *
+ * The *_unchecked functions skip bounds checks for hot loops
+ */
+template <class Index = std::uint32_t>
+class disjoint_set {
+    private:
+        vector<Index> parents;
+        vector<uint8_t> ranks;
+        size_t num_sets;
+
+        void check_index(size_t index, const char* caller) const {
+            if (index >= parents.size()) {
+                cerr << "disjoint_set." << caller << "(): index out of bounds\n";
+                exit(1);
+            }
+        }
+    public:
+        disjoint_set() : num_sets(0) {}
+        disjoint_set(size_t size) : num_sets(0) {
+            if (size > (size_t) std::numeric_limits<Index>::max()) {
+                cerr << "disjoint_set: size does not fit in the index type\n";
+                exit(1);
+            }
+            parents.reserve(size);
+            ranks.reserve(size);
+            for (size_t i = 0; i < size; ++i) add();
+        }
+        /**
+         * Add a new singleton set
+         *
+         * @return index of the new element
+         */
+        size_t add() {
+            parents.push_back((Index) parents.size());
+            ranks.push_back(0);
+            num_sets++;
+            return parents.size() - 1;
+        }
+        // number of elements
+        size_t size() const {
+            return parents.size();
+        }
+        // number of disjoint sets
+        size_t sets() const {
+            return num_sets;
+        }
+        void reserve(size_t size) {
+            parents.reserve(size);
+            ranks.reserve(size);
+        }
+        /**
+         * Get the root of the set containing an element
+         * Halves the path on the way up
+         */
+        Index find_unchecked(Index index) {
+            while (parents[index] != index) {
+                parents[index] = parents[parents[index]];
+                index = parents[index];
+            }
+            return index;
+        }
+        /**
+         * Merge the sets containing two elements
+         *
+         * @return whether the two sets were merged or not
+         */
+        bool union_unchecked(Index a, Index b) {
+            Index set_a = find_unchecked(a), set_b = find_unchecked(b);
+            if (set_a == set_b) return false;
+            if (ranks[set_a] > ranks[set_b]) parents[set_b] = set_a;
+            else {
+                parents[set_a] = set_b;
+                if (ranks[set_a] == ranks[set_b]) ranks[set_b]++;
+            }
+            num_sets--;
+            return true;
+        }
+        size_t find_set(size_t index) {
+            check_index(index, "find_set");
+            return find_unchecked((Index) index);
+        }
+        bool union_sets(size_t a, size_t b) {
+            check_index(a, "union_sets");
+            check_index(b, "union_sets");
+            return union_unchecked((Index) a, (Index) b);
+        }
+};
+
+#endif
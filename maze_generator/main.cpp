@@ -1,23 +1,437 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <list>
+#include <random>
+#include <iterator>
+#include <cstdio>
+#include <sys/resource.h>
 #include "maze.h"
+#include "threading.h"
+
+using std::cout;
+using std::cerr;
+using namespace std::chrono;
 
 void test_small() {
     string algorithms[] = { "dfs", "kruskal", "prim", "aldous-broder" };
-    for (string alg : algorithms)
-        benchmark_maze(5, 5, alg, true, true, "maze_examples/" + alg + "_maze_small.txt", false);
-    for (string alg : algorithms)
-        benchmark_maze(5, 5, alg, true, true, "maze_examples/" + alg + "_maze_small_binary.txt", true);
+    for (string alg : algorithms) {
+        auto maze = generate_maze(5, 5, alg);
+        display_maze(*maze);
+        save_maze(*maze, "maze_examples/" + alg + "_maze_small.txt", false);
+        save_maze(*maze, "maze_examples/" + alg + "_maze_small_binary.txt", true);
+    }
 }
 
 void test_large() {
     string algorithms[] = { "dfs", "kruskal", "prim", "aldous-broder" };
-    for (string alg : algorithms)
-        benchmark_maze(25, 25, alg, true, false, "maze_examples/" + alg + "_maze.txt", false);
-    for (string alg : algorithms)
-        benchmark_maze(25, 25, alg, true, true, "maze_examples/" + alg + "_maze_binary.txt", true);
+    for (string alg : algorithms) {
+        auto maze = generate_maze(25, 25, alg);
+        display_maze(*maze);
+        save_maze(*maze, "maze_examples/" + alg + "_maze_binary.txt", true);
+    }
+}
+
+/**
+ * Check that binary maze files and archives with a short or lying header are
+ * rejected instead of mapped
+ */
+void test_malformed_files() {
+    string file = "malformed_maze.bin";
+    auto write_file = [&](size_t width, size_t height, size_t payload, size_t keep) {
+        std::stringstream bytes;
+        write_maze_header(bytes, width, height, "kruskal", 1);
+        bytes << string(payload, '\0');
+        std::ofstream(file, std::ios::binary) << bytes.str().substr(0, keep);
+    };
+    struct malformed_case {
+        const char* name;
+        size_t width, height, payload, keep;
+        bool valid;
+    };
+    const size_t all = (size_t) -1;
+    malformed_case cases[] = {
+        {"valid", 5, 5, 7, all, true},
+        {"truncated header", 5, 5, 7, 40, false},
+        {"truncated payload", 5, 5, 7, 68, false},
+        {"overflowing size", 3, (size_t) -1 / 3, 0, all, false},
+        {"overflowing product", (size_t) 1 << 32, (size_t) 1 << 32, 0, all, false},
+    };
+    for (const malformed_case& test : cases) {
+        write_file(test.width, test.height, test.payload, test.keep);
+        bool mapped = map_maze_file(file) != nullptr;
+        bool archived = !map_maze_archive(file).empty();
+        cout << "maze file " << test.name << ": " << (mapped == test.valid && archived == test.valid
+            ? "ok" : "FAILED") << "\n";
+    }
+    std::remove(file.c_str());
+}
+
+/**
+ * Scaling of a multi-threaded generator from 1 thread up to one per hardware thread
+ * Defaults to a 10^8 cell maze
+ */
+void benchmark_scaling(string algorithm, size_t width=10000, size_t height=10000) {
+    size_t max_threads = resolve_thread_count(0);
+    for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        auto start = high_resolution_clock::now();
+        auto maze = generate_maze(width, height, algorithm, 0, 0, true, false, threads, 0, 1);
+        auto stop = high_resolution_clock::now();
+        cout << algorithm << " " << width << "x" << height << ", " << threads << " threads: " 
+            << duration_cast<milliseconds>(stop - start).count() << " ms\n";
+        if (threads == max_threads) break;
+    }
+}
+
+/**
+ * Previous Prim's implementation, kept as a baseline for benchmark_prim
+ * The frontier is a list and every wall is inserted at a random position,
+ * which makes each insert O(frontier size)
+ */
+unique_ptr<MazeGrid> prim_list_reference(size_t width, size_t height) {
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 gen(rd()); // seed the generator
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
+
+    unique_ptr<MazeGrid> maze{new MazeGrid(width*2+1, height*2+1, 1)};
+    for (size_t j = 1; j < maze->height(); j+=2)
+        for (size_t i = 1; i < maze->width(); i+=2) (*maze)(i, j) = 0;
+    std::list<size_t> walls;
+    vector<bool> visited(width*height, false);
+    auto add_walls = [&](size_t x, size_t y) {
+        size_t cell = y * width + x;
+        for (int dir = 0; dir < 4; ++dir) {
+            long long nx = (long long) x + dx[dir], ny = (long long) y + dy[dir];
+            if (nx < 0 || ny < 0 || nx >= (long long) width || ny >= (long long) height 
+                || visited[ny * width + nx]) continue;
+            std::list<size_t>::iterator position = walls.begin();
+            if (!walls.empty()) 
+                std::advance(position, std::uniform_int_distribution<size_t>(0, walls.size()-1)(gen));
+            walls.insert(position, 4 * cell + dir);
+        }
+        visited[cell] = true;
+    };
+    add_walls(0, 0);
+    while (!walls.empty()) {
+        size_t current_wall = walls.front();
+        walls.pop_front();
+        size_t cell = current_wall / 4, x = cell % width, y = cell / width;
+        Direction dir = (Direction) (current_wall % 4);
+        if (!visited[(y + dy[dir]) * width + x + dx[dir]]) {
+            maze->open_wall(x, y, dir);
+            add_walls(x + dx[dir], y + dy[dir]);
+        }
+    }
+    return maze;
+}
+
+/**
+ * Compare the list based Prim's against the current vector frontier
+ * The list version needs tens of minutes at 4096x4096
+ */
+void benchmark_prim() {
+    size_t sizes[] = { 256, 1024, 4096 };
+    for (size_t size : sizes) {
+        auto start = high_resolution_clock::now();
+        auto reference = prim_list_reference(size, size);
+        auto middle = high_resolution_clock::now();
+        auto maze = prim(size, size);
+        auto stop = high_resolution_clock::now();
+        cout << "prim " << size << "x" << size << ": list " 
+            << duration_cast<milliseconds>(middle - start).count() << " ms, vector " 
+            << duration_cast<milliseconds>(stop - middle).count() << " ms\n";
+    }
+}
+
+/**
+ * Previous depth-first search, kept as a baseline for benchmark_dfs
+ * Allocates a neighbor vector on every step, stores 16 byte coordinate pairs on
+ * the stack, uses nested visited vectors and redraws until the choice is in range
+ */
+unique_ptr<MazeGrid> dfs_reference(size_t width, size_t height) {
+    std::random_device rd; // obtain a random number from hardware
+    std::mt19937 gen(rd()); // seed the generator
+    std::uniform_int_distribution<> distr(0, 3); 
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
+
+    unique_ptr<MazeGrid> maze{new MazeGrid(width*2+1, height*2+1, 1)};
+    for (size_t j = 1; j < maze->height(); j+=2)
+        for (size_t i = 1; i < maze->width(); i+=2) (*maze)(i, j) = 0;
+    vector<vector<bool>> visited(width, vector<bool>(height, false));
+    vector<std::pair<size_t, size_t>> stack;
+    stack.push_back(std::make_pair(0, 0));
+    visited[0][0] = true;
+    while (!stack.empty()) {
+        std::pair<size_t, size_t> current = stack.back();
+        stack.pop_back();
+        size_t x = current.first, y = current.second;
+        vector<Direction> unvisited_neighbors;
+        unvisited_neighbors.reserve(4);
+        if (x > 0 && !visited[x-1][y]) unvisited_neighbors.push_back(WEST);
+        if (x < width-1 && !visited[x+1][y]) unvisited_neighbors.push_back(EAST);
+        if (y > 0 && !visited[x][y-1]) unvisited_neighbors.push_back(NORTH);
+        if (y < height-1 && !visited[x][y+1]) unvisited_neighbors.push_back(SOUTH);
+        if (unvisited_neighbors.size() > 0) {
+            int choice = distr(gen);
+            while (choice >= (int)unvisited_neighbors.size())
+                choice = distr(gen);
+            Direction neighbor = unvisited_neighbors[choice];
+            stack.push_back(current);
+            maze->open_wall(x, y, neighbor);
+            visited[x+dx[neighbor]][y+dy[neighbor]] = true; 
+            stack.push_back(std::make_pair(x+dx[neighbor], y+dy[neighbor]));
+        }
+    }
+    return maze;
+}
+
+/**
+ * Compare the previous depth-first search against the current one
+ */
+void benchmark_dfs(size_t size=4096) {
+    auto start = high_resolution_clock::now();
+    auto reference = dfs_reference(size, size);
+    auto middle = high_resolution_clock::now();
+    auto maze = randomized_depth_first_search(size, size);
+    auto stop = high_resolution_clock::now();
+    cout << "dfs " << size << "x" << size << ": previous " 
+        << duration_cast<milliseconds>(middle - start).count() << " ms, current " 
+        << duration_cast<milliseconds>(stop - middle).count() << " ms\n";
+}
+
+/**
+ * Compare loading a maze from the text format against mapping the binary maze file
+ */
+void benchmark_maze_file(size_t size=4096, string algorithm="kruskal") {
+    uint64_t seed = 1;
+    auto maze = generate_packed_maze(size, size, algorithm, 0, 0, true, 0, 0, seed);
+    save_maze(*maze, "benchmark_maze.txt", true);
+    save_maze_file(*maze, "benchmark_maze.bin", algorithm, seed);
+    auto start = high_resolution_clock::now();
+    auto grid = load_maze("benchmark_maze.txt");
+    auto middle = high_resolution_clock::now();
+    auto mapped = map_maze_file("benchmark_maze.bin");
+    auto stop = high_resolution_clock::now();
+    size_t walls = 0; // touch every page of the mapping
+    for (size_t i = 0; i < mapped->bytes(); ++i) walls += __builtin_popcount(mapped->data()[i]);
+    auto touched = high_resolution_clock::now();
+    cout << "load " << size << "x" << size << ": text " 
+        << duration_cast<milliseconds>(middle - start).count() << " ms, mapped " 
+        << duration_cast<microseconds>(stop - middle).count() << " us, read mapped "
+        << duration_cast<milliseconds>(touched - middle).count() << " ms (" << walls << " wall bits)\n";
+    std::remove("benchmark_maze.txt");
+    std::remove("benchmark_maze.bin");
 }
 
-int main() {
-    test_small();
-    test_large();
-    // auto i = recursive_division(10, 5);
-}
\ No newline at end of file
+/**
+ * Previous text maze parser, kept as a baseline for benchmark_load
+ * Reads line by line and collects the "█" glyph one byte at a time
+ */
+unique_ptr<MazeGrid> load_maze_reference(string file_path) {
+    std::ifstream infile(file_path);
+    if (!infile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        exit(1);
+    }
+    string line;
+    size_t width = 0, height = 0;
+    vector<uint8_t> cells; // row-major, width is fixed by the first line
+    while (std::getline(infile, line)) {
+        string wall_cell = "";
+        size_t row = 0;
+        size_t double_index = 0; // track the double chars
+        for (char cell : line) {
+            if (cell == '0' || cell == '1') {
+                cells.push_back(cell - '0');
+                row++;
+            }
+            else if (cell == ' ') {
+                double_index++;
+                if (double_index % 2 == 0) {
+                    cells.push_back(0);
+                    row++;
+                }
+            }
+            else {
+                wall_cell += cell;
+                if (wall_cell == "█") { // this is made up of multiple chars
+                    double_index++;
+                    if (double_index % 2 == 0) {
+                        cells.push_back(1);
+                        row++;
+                    }
+                    wall_cell.clear();
+                }
+            }
+        }
+        if (height == 0) width = row;
+        if (row != width) {
+            cerr << "ERROR: maze rows have different lengths!\n";
+            exit(1);
+        }
+        height++;
+    }
+    MazeGrid* grid = new MazeGrid(width, height);
+    std::copy(cells.begin(), cells.end(), grid->data());
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Compare the previous text parser against the current one on both text formats
+ */
+void benchmark_load(size_t size=2048, string algorithm="kruskal") {
+    auto maze = generate_packed_maze(size, size, algorithm, 0, 0, true, 0, 0, 1);
+    for (bool binary : {true, false}) {
+        save_maze(*maze, "benchmark_maze.txt", binary);
+        double megabytes = std::ifstream("benchmark_maze.txt", std::ios::ate | std::ios::binary).tellg() / 1e6;
+        auto start = high_resolution_clock::now();
+        auto reference = load_maze_reference("benchmark_maze.txt");
+        auto middle = high_resolution_clock::now();
+        auto grid = load_maze("benchmark_maze.txt");
+        auto stop = high_resolution_clock::now();
+        bool same = grid && std::equal(grid->data(), grid->data() + grid->width() * grid->height(), 
+            reference->data());
+        double previous = duration_cast<microseconds>(middle - start).count() / 1e3, 
+            current = duration_cast<microseconds>(stop - middle).count() / 1e3;
+        cout << "load " << (binary ? "binary " : "display ") << size << "x" << size << " (" << megabytes 
+            << " MB): previous " << previous << " ms, current " << current << " ms, " 
+            << megabytes / current << " GB/s" << (same ? "" : ", MISMATCH") << "\n";
+    }
+    std::remove("benchmark_maze.txt");
+}
+
+/**
+ * Stream a maze to disk row by row and report the rate and the peak memory used
+ */
+void benchmark_stream(size_t width=100000, size_t height=10000, string algorithm="eller", 
+    string format="packed") {
+    auto start = high_resolution_clock::now();
+    stream_maze(width, height, "benchmark_stream.maze", algorithm, format, 1);
+    auto stop = high_resolution_clock::now();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double seconds = duration_cast<microseconds>(stop - start).count() / 1e6;
+    cout << algorithm << " stream " << width << "x" << height << " (" << format << "): " 
+        << (size_t) (seconds * 1000) << " ms, " << width * height / seconds / 1e6 << " Mcells/s, peak RSS " 
+        << usage.ru_maxrss / 1024 << " MB\n";
+    std::remove("benchmark_stream.maze");
+}
+
+/**
+ * Compare drawing frames of a maze one glyph at a time against the buffered
+ * renderer, redrawing everything and sending only the changes
+ * Each frame opens one more wall, as in an animation. Output goes to /dev/null.
+ */
+void benchmark_frames(size_t size=500, size_t frames=200) {
+    auto maze = generate_packed_maze(size, size, "dfs", 0, 0, true, 0, 0, 1);
+    auto grid = maze->expand();
+    std::ofstream null_stream("/dev/null");
+    FILE* null_file = std::fopen("/dev/null", "w");
+    auto frame_change = [&](size_t frame) { // close then reopen a wall, so the maze stays the same
+        size_t x = 2 * (frame % size) + 1, y = 2 * (frame / size % size) + 1;
+        (*grid)(x, y) = frame % 2;
+    };
+
+    auto start = high_resolution_clock::now();
+    for (size_t frame = 0; frame < frames; ++frame) {
+        frame_change(frame);
+        for (size_t j = 0; j < grid->height(); ++j) {
+            for (size_t i = 0; i < grid->width(); ++i) null_stream << ((*grid)(i, j) == 1 ? "██" : "  ");
+            null_stream << "\n";
+        }
+    }
+    auto middle = high_resolution_clock::now();
+    terminal_renderer full(false, false, false, 0, null_file);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        frame_change(frame);
+        full.draw(*grid);
+    }
+    auto later = high_resolution_clock::now();
+    terminal_renderer diff(false, false, true, 0, null_file);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        frame_change(frame);
+        diff.draw(*grid);
+    }
+    auto stop = high_resolution_clock::now();
+    std::fclose(null_file);
+    cout << frames << " frames of " << size << "x" << size << ": per glyph " 
+        << duration_cast<milliseconds>(middle - start).count() << " ms, buffered " 
+        << duration_cast<milliseconds>(later - middle).count() << " ms, diff "
+        << duration_cast<milliseconds>(stop - later).count() << " ms\n";
+}
+
+/**
+ * Time one generator with a given engine type
+ */
+template <class URNG>
+long long time_engine(string algorithm, uint64_t seed, PackedMaze& maze) {
+    URNG gen((typename URNG::result_type) seed);
+    auto start = high_resolution_clock::now();
+    if (algorithm == "dfs") carve_depth_first_search(maze, gen);
+    else if (algorithm == "kruskal") carve_kruskal(maze, gen);
+    else carve_aldous_broder(maze, gen);
+    auto stop = high_resolution_clock::now();
+    return duration_cast<milliseconds>(stop - start).count();
+}
+
+/**
+ * Compare the Mersenne Twister against xoshiro256 as the engine of the generators
+ * most bound by random draws, and check that a seed reproduces the same maze
+ */
+void benchmark_engines(size_t size=2048) {
+    string algorithms[] = { "dfs", "kruskal", "aldous-broder" };
+    for (string algorithm : algorithms) {
+        PackedMaze maze(size, size);
+        long long twister = time_engine<std::mt19937>(algorithm, 1, maze);
+        long long xoshiro = time_engine<xoshiro256>(algorithm, 1, maze);
+        auto again = generate_packed_maze(size, size, algorithm, 0, 0, true, 0, 0, 1);
+        bool reproduced = std::equal(maze.data(), maze.data() + maze.bytes(), again->data());
+        cout << algorithm << " " << size << "x" << size << ": mt19937 " << twister << " ms, xoshiro256 "
+            << xoshiro << " ms, " << (reproduced ? "reproduced" : "NOT reproduced") << " from its seed\n";
+    }
+}
+
+/**
+ * Benchmarks run by name from the command line instead of the default tests,
+ * e.g. ./maze prim engines
+ */
+struct named_run {
+    const char* name;
+    void (*run)();
+};
+
+static const named_run runs[] = {
+    {"scaling-kruskal", [] { benchmark_scaling("kruskal-parallel"); }},
+    {"scaling-division", [] { benchmark_scaling("recursive-division"); }},
+    {"prim", [] { benchmark_prim(); }},
+    {"dfs", [] { benchmark_dfs(); }},
+    {"maze-file", [] { benchmark_maze_file(); }},
+    {"stream", [] { benchmark_stream(); }},
+    {"frames", [] { benchmark_frames(); }},
+    {"load", [] { benchmark_load(); }},
+    {"engines", [] { benchmark_engines(); }},
+};
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        test_small();
+        test_large();
+        test_malformed_files();
+        // auto i = recursive_division(10, 5);
+        return 0;
+    }
+    vector<const named_run*> selected;
+    for (int i = 1; i < argc; ++i) {
+        for (const named_run& run : runs)
+            if (string(argv[i]) == run.name) selected.push_back(&run);
+        if (selected.size() == (size_t) i - 1) {
+            cerr << "ERROR: unknown benchmark " << argv[i] << ", expected one of:";
+            for (const named_run& run : runs) cerr << " " << run.name;
+            cerr << "\n";
+            return 1;
+        }
+    }
+    for (const named_run* run : selected) run->run();
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using std::string;
+using std::size_t;
+
+/**
+ * Whole file mapped read-only into memory for parsing
+ * The mapping is released when the object is destroyed. Empty files are not
+ * mapped and read as zero bytes.
+ */
+class mapped_file {
+    private:
+        const char* bytes;
+        size_t length;
+        bool opened;
+
+        mapped_file(const mapped_file&);
+        mapped_file& operator=(const mapped_file&);
+    public:
+        explicit mapped_file(string file_path) : bytes(nullptr), length(0), opened(false) {
+            int fd = open(file_path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat info;
+            if (fstat(fd, &info) == 0) {
+                length = (size_t) info.st_size;
+                opened = true;
+                if (length > 0) {
+                    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapping == MAP_FAILED) opened = false, length = 0;
+                    else {
+                        bytes = (const char*) mapping;
+                        madvise(mapping, length, MADV_SEQUENTIAL); // read once front to back
+                    }
+                }
+            }
+            close(fd);
+        }
+        ~mapped_file() {
+            if (bytes) munmap((void*) bytes, length);
+        }
+
+        // whether the file could be opened and mapped
+        bool is_open() const { return opened; }
+        const char* data() const { return bytes; }
+        size_t size() const { return length; }
+};
+
+#endif
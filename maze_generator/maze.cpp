@@ -5,11 +5,17 @@
 #include <random>
 #include <cmath>
 #include <algorithm>
-#include <list>
-#include <iterator>
 #include <chrono>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <cstring>
 
-#include "union_find_forest.h"
+#include "disjoint_set.h"
+#include "concurrent_disjoint_set.h"
+#include "threading.h"
+#include "mapped_file.h"
+#include "random.h"
 #include "maze.h"
 
 using namespace std::chrono;
@@ -17,27 +23,51 @@ using namespace std::chrono;
 using std::cout;
 using std::cerr;
 using std::make_pair;
-using std::list;
 
 /**
  * Print maze to stdout
  */ 
+void display_maze(const MazeGrid& grid) {
+    terminal_renderer().draw(grid);
+}
+
 void display_maze(vector<vector<int>>& grid) {
-    for (size_t j = 0; j < grid[0].size(); ++j) {
-        for (size_t i = 0; i < grid.size(); ++i) {
-            if (grid[i][j] == 1)
-                cout << "██";
-            else if (grid[i][j] == 0)
-                cout << "  ";
-        }
-        cout << "\n";
-    }
+    display_maze(MazeGrid(grid));
+}
+
+/**
+ * Print a packed maze to stdout one expanded row at a time
+ */
+void display_maze(const PackedMaze& maze) {
+    terminal_renderer().draw(maze);
+}
+
+/**
+ * Renderer shared by the generators for show_frames
+ * Frames only send the walls that changed and are limited to 60 per second,
+ * so most steps of a large maze are skipped
+ */
+static terminal_renderer& frame_renderer() {
+    static terminal_renderer renderer(false, false, true, 60);
+    return renderer;
+}
+
+template <class Maze>
+static void display_frame(const Maze& maze) {
+    frame_renderer().draw(maze);
+}
+
+// draw the finished maze whatever the frame rate, the next animation starts on a cleared screen
+template <class Maze>
+static void display_last_frame(const Maze& maze) {
+    frame_renderer().draw(maze, true);
+    frame_renderer().restart();
 }
 
 /**
  * Save maze to a file
  */ 
-void save_maze(vector<vector<int>>& grid, string file_path, bool binary) {
+void save_maze(const MazeGrid& grid, string file_path, bool binary) {
     std::ofstream outfile(file_path);
     if (!outfile.is_open()) {
         cerr << "ERROR: unable to open file!\n";
@@ -45,70 +75,197 @@ void save_maze(vector<vector<int>>& grid, string file_path, bool binary) {
     }
     string wall = "██", path = "  ";
     if (binary) wall = "1", path = "0"; 
-    for (size_t j = 0; j < grid[0].size(); ++j) {
-        for (size_t i = 0; i < grid.size(); ++i) {
-            if (grid[i][j] == 1)
+    for (size_t j = 0; j < grid.height(); ++j) {
+        const uint8_t* row = grid.row(j);
+        for (size_t i = 0; i < grid.width(); ++i) {
+            if (row[i] == 1)
                 outfile << wall;
-            else if (grid[i][j] == 0)
+            else if (row[i] == 0)
                 outfile << path;
         }
         outfile << "\n";
     }
 }
 
+void save_maze(vector<vector<int>>& grid, string file_path, bool binary) {
+    save_maze(MazeGrid(grid), file_path, binary);
+}
 
 /**
- * Open a saved maze from a file
- */ 
-unique_ptr<vector<vector<int>>> load_maze(string file_path, bool display) {
-    std::ifstream infile(file_path);
-    if (!infile.is_open()) {
+ * Save a packed maze in the legacy text format one expanded row at a time
+ */
+void save_maze(const PackedMaze& maze, string file_path, bool binary) {
+    std::ofstream outfile(file_path);
+    if (!outfile.is_open()) {
         cerr << "ERROR: unable to open file!\n";
         exit(1);
     }
-    string line;
-    bool is_first = true;
-    vector<vector<int>>* grid = new vector<vector<int>>();
-    while (std::getline(infile, line)) {
-        if (display) cout << line << "\n";
-        string wall_cell = "";
-        size_t row = 0;
-        size_t double_index = 0; // track the double chars
-        for (char cell : line) {
-            if (cell == '0') {
-                if (is_first) grid->push_back(vector<int>());
-                (*grid)[row].push_back(0);
-                row++;
-            }
-            else if (cell == '1') {
-                if (is_first) grid->push_back(vector<int>());
-                (*grid)[row].push_back(1);
-                row++;
+    string wall = "██", path = "  ";
+    if (binary) wall = "1", path = "0"; 
+    vector<uint8_t> row(2 * maze.cell_width() + 1);
+    for (size_t j = 0; j < 2 * maze.cell_height() + 1; ++j) {
+        maze.expand_row(j, row.data());
+        for (size_t i = 0; i < row.size(); ++i)
+            outfile << (row[i] == 1 ? wall : path);
+        outfile << "\n";
+    }
+}
+
+
+static unique_ptr<MazeGrid> text_error(const string& file_path, size_t line, size_t column, const string& message) {
+    cerr << "ERROR: " << file_path << ":" << line << ":" << column << ": " << message << "\n";
+    return unique_ptr<MazeGrid>();
+}
+
+static unique_ptr<MazeGrid> row_length_error(const string& file_path, size_t line, size_t column, size_t width) {
+    return text_error(file_path, line, column, "row does not have " + std::to_string(width) + " slots");
+}
+
+/**
+ * Parse one line of 0s and 1s into slots
+ * The loop has no branches so it is vectorized, bad bytes are only located
+ * once one is known to be there
+ *
+ * @param column set to the 1-based column of the first bad byte
+ * @return false if the line has any byte other than 0 and 1
+ */
+static bool parse_binary_line(const char* line, size_t length, uint8_t* slots, size_t& column) {
+    uint8_t bad = 0;
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t slot = (uint8_t) (line[i] - '0');
+        slots[i] = slot;
+        bad |= (uint8_t) (slot > 1);
+    }
+    if (!bad) return true;
+    for (column = 1; (uint8_t) (line[column - 1] - '0') <= 1; ++column) {}
+    return false;
+}
+
+/**
+ * Parse one line of blocks and spaces into slots
+ * Runs of walls are found by searching for the next space, and each run is
+ * checked against the 6 bytes of a wall and filled at once
+ *
+ * @param capacity most slots the line may hold
+ * @param count set to the number of slots parsed
+ * @param column set to the 1-based column of the first bad byte
+ * @return false if the line is not made of "██" and "  ", or has more than capacity
+ *         slots in which case count is capacity
+ */
+static bool parse_block_line(const char* line, size_t length, uint8_t* slots, size_t capacity,
+    size_t& count, size_t& column) {
+    static const char walls[] = "████████████████████████████████"; // 16 walls of two blocks
+    const size_t chunk_length = sizeof(walls) - 1, wall_length = chunk_length / 16;
+    const char *p = line, *end = line + length;
+    count = 0;
+    while (p < end) {
+        const char* q = p;
+        size_t run;
+        if (*p == ' ') {
+            while (q < end && *q == ' ') ++q;
+            run = (size_t) (q - p) / 2;
+            if ((q - p) % 2 != 0) {
+                column = (size_t) (q - line);
+                return false;
             }
-            else if (cell == ' ') {
-                double_index++;
-                if (double_index % 2 == 0) {
-                    if (is_first) grid->push_back(vector<int>());
-                    (*grid)[row].push_back(0);
-                    row++;
+        }
+        else {
+            q = (const char*) std::memchr(p, ' ', end - p);
+            if (!q) q = end;
+            run = (size_t) (q - p) / wall_length;
+            size_t checked = 0, run_bytes = (size_t) (q - p);
+            if (run_bytes == run * wall_length) { // compare whole chunks of walls first
+                for (; checked < run_bytes; checked += chunk_length) {
+                    size_t chunk = std::min(chunk_length, run_bytes - checked);
+                    if (std::memcmp(p + checked, walls, chunk) != 0) break;
                 }
             }
-            else {
-                wall_cell += cell;
-                if (wall_cell == "█") { // this is made up of multiple chars
-                    double_index++;
-                    if (double_index % 2 == 0) {
-                        if (is_first) grid->push_back(vector<int>());
-                        (*grid)[row].push_back(1);
-                        row++;
-                    }
-                    wall_cell.clear();
-                }
+            if (checked < run_bytes) { // find the bad glyph
+                const char* glyph = p;
+                while (glyph + wall_length <= q && std::memcmp(glyph, walls, wall_length) == 0) glyph += wall_length;
+                column = (size_t) (glyph - line) + 1;
+                return false;
             }
         }
-        if (is_first) is_first = false;
+        if (count + run > capacity) { // count is left at capacity
+            column = (size_t) (p - line) + 1 + (capacity - count) * (*p == ' ' ? 2 : wall_length);
+            count = capacity;
+            return false;
+        }
+        std::memset(slots + count, *p == ' ' ? 0 : 1, run);
+        count += run;
+        p = q;
     }
-    return unique_ptr<vector<vector<int>>>{grid};
+    return true;
+}
+
+/**
+ * Open a saved maze from a file, in either text format
+ * The file is mapped and its rows counted up front, then every line is parsed
+ * straight into its row of the grid. The format is taken from the first byte.
+ *
+ * @param display print the file as it is read
+ * @return empty if the file cannot be opened or is malformed, with the line
+ *         and column of the problem
+ */ 
+unique_ptr<MazeGrid> load_maze(string file_path, bool display) {
+    mapped_file file(file_path);
+    if (!file.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        return unique_ptr<MazeGrid>();
+    }
+    const char *data = file.data(), *end = data + file.size();
+    if (display && file.size() > 0) {
+        cout.write(data, file.size());
+        if (end[-1] != '\n') cout << "\n";
+    }
+    size_t height = 0;
+    for (const char* p = data; p < end; ++height) {
+        const char* newline = (const char*) std::memchr(p, '\n', end - p);
+        p = newline ? newline + 1 : end;
+    }
+    if (height == 0) return unique_ptr<MazeGrid>{new MazeGrid(0, 0)};
+
+    bool blocks = data[0] == ' ' || (uint8_t) data[0] == 0xE2;
+    unique_ptr<MazeGrid> grid;
+    vector<uint8_t> first_row;
+    size_t width = 0;
+    const char* line = data;
+    for (size_t j = 0; j < height; ++j) {
+        const char* newline = (const char*) std::memchr(line, '\n', end - line);
+        size_t length = (size_t) ((newline ? newline : end) - line);
+        if (length > 0 && line[length - 1] == '\r') length--;
+        size_t count = length, column = 0;
+        uint8_t* slots;
+        if (j == 0) { // the first line sets the width
+            first_row.resize(length);
+            slots = first_row.data();
+        }
+        else slots = grid->row(j);
+        if (!blocks && j > 0 && length != width)
+            return row_length_error(file_path, j + 1, std::min(length, width) + 1, width);
+        bool parsed = blocks ? parse_block_line(line, length, slots, j == 0 ? length : width, count, column)
+            : parse_binary_line(line, length, slots, column);
+        if (!parsed && blocks && count == width && j > 0) return row_length_error(file_path, j + 1, column, width);
+        if (!parsed) return text_error(file_path, j + 1, column, "expected a wall or a path");
+        if (j == 0) {
+            width = count;
+            grid.reset(new MazeGrid(width, height));
+            std::copy(first_row.begin(), first_row.begin() + width, grid->row(0));
+        }
+        else if (count != width) return row_length_error(file_path, j + 1, length + 1, width);
+        line = newline ? newline + 1 : end;
+    }
+    return grid;
+}
+
+/**
+ * Open a saved maze into the legacy column-major nested vector layout (grid[x][y])
+ */
+unique_ptr<vector<vector<int>>> load_maze_nested(string file_path, bool display) {
+    auto grid = load_maze(file_path, display);
+    if (!grid) return unique_ptr<vector<vector<int>>>();
+    return grid->to_nested();
 }
 
 /**
@@ -118,8 +275,7 @@ unique_ptr<vector<vector<int>>> load_maze(string file_path, bool display) {
  */ 
 template <class URNG>
 pair<size_t, size_t> random_coordinate(URNG& gen, size_t width, size_t height) {
-    std::uniform_int_distribution<> distr(0, width*height - 1);
-    int index = distr(gen); // get random 1D index
+    size_t index = (size_t) bounded_draw64(gen, width*height); // get random 1D index
     size_t y = index / width;
     size_t x = index - (y * width);
     return make_pair(x, y);
@@ -127,15 +283,11 @@ pair<size_t, size_t> random_coordinate(URNG& gen, size_t width, size_t height) {
 
 /**
  * Generate a random coordinate from the maze cells without providing a generator
+ * Each thread seeds its own generator once
  */
 pair<size_t, size_t> random_coordinate(size_t width, size_t height) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-    std::uniform_int_distribution<> distr(0, width*height - 1);
-    int index = distr(gen); // get random 1D index
-    size_t y = index / width;
-    size_t x = index - (y * width);
-    return make_pair(x, y);
+    static thread_local xoshiro256 gen(random_seed());
+    return random_coordinate(gen, width, height);
 }
 
 /**
@@ -145,359 +297,943 @@ pair<size_t, size_t> random_coordinate(size_t width, size_t height) {
  */ 
 template <class URNG>
 pair<size_t, size_t> random_maze_coordinate(URNG& gen, size_t width, size_t height) {
-    std::uniform_int_distribution<> distr(0, width*height - 1);
-    int index = distr(gen); // get random 1D index
+    size_t index = (size_t) bounded_draw64(gen, width*height); // get random 1D index
     size_t y = index / width;
     size_t x = index - (y * width);
     return make_pair(2 * x + 1, 2 * y + 1); // translate to grid coords
 }
 
+bool is_generator_algorithm(string algorithm) {
+    return algorithm == "dfs" || algorithm == "kruskal" || algorithm == "kruskal-parallel" || algorithm == "prim"
+        || algorithm == "aldous-broder" || algorithm == "recursive-division" || algorithm == "wilson"
+        || algorithm == "aldous-broder-wilson" || MazeRowStream::is_row_algorithm(algorithm);
+}
+
 /**
- * Generate a random maze using a chosen algorithm
+ * Generate a random maze into an existing maze of any representation
  * 
- * @param algorithm algorithm to use for generation (dfs, kruskal, prim, aldous-broder)
+ * @param algorithm algorithm to use for generation (dfs, kruskal, kruskal-parallel, prim,
+ *                  aldous-broder, wilson, aldous-broder-wilson, recursive-division, eller,
+ *                  sidewinder, binary-tree)
  * @param random_start if true, uses random starting point, overriding startX and startY
  *                     if applicable
+ * @param threads threads for the parallel algorithms and for tiles, 0 uses one per hardware thread
+ * @param tile_size if not 0, generate tiles of this many cells a side in parallel and stitch them,
+ *                  see carve_tiled
+ * @param seed seed of the generator, the same seed and arguments give the same maze
+ * @return false if the algorithm is invalid
  */
-unique_ptr<vector<vector<int>>> generate_maze(size_t width, size_t height, string algorithm,
-    size_t startX, size_t startY, bool random_start, bool show_frames) {
-    if (algorithm == "dfs")
-        return randomized_depth_first_search(width, height, startX, startY, random_start, show_frames);
+template <class Maze>
+bool generate_maze_into(Maze& maze, string algorithm, size_t startX, size_t startY, 
+    bool random_start, bool show_frames, size_t threads, size_t tile_size, uint64_t seed) {
+    xoshiro256 gen(seed);
+    if (tile_size > 0 && is_generator_algorithm(algorithm) 
+        && (tile_size < maze.cell_width() || tile_size < maze.cell_height()))
+        carve_tiled(maze, gen, algorithm, tile_size, threads, show_frames);
+    else if (algorithm == "dfs")
+        carve_depth_first_search(maze, gen, startX, startY, random_start, show_frames);
     else if (algorithm == "kruskal")
-        return kruskal(width, height, show_frames);
+        carve_kruskal(maze, gen, show_frames);
+    else if (algorithm == "kruskal-parallel")
+        carve_kruskal_parallel(maze, gen, threads, show_frames);
     else if (algorithm == "prim")
-        return prim(width, height, startX, startY, random_start, show_frames);
+        carve_prim(maze, gen, startX, startY, random_start, show_frames);
     else if (algorithm == "aldous-broder")
-        return aldous_broder(width, height, show_frames);
+        carve_aldous_broder(maze, gen, show_frames);
+    else if (algorithm == "recursive-division")
+        carve_recursive_division(maze, gen, threads, show_frames);
+    else if (algorithm == "wilson")
+        carve_wilson(maze, gen, show_frames);
+    else if (algorithm == "aldous-broder-wilson")
+        carve_aldous_broder_wilson(maze, gen, 1.0 / 3, show_frames);
+    else if (algorithm == "eller")
+        carve_eller(maze, gen, show_frames);
+    else if (algorithm == "sidewinder")
+        carve_sidewinder(maze, gen, show_frames);
+    else if (algorithm == "binary-tree")
+        carve_binary_tree(maze, gen, show_frames);
     else {
         cerr << "ERROR: invalid maze generation algorithm provided!\n";
-        return unique_ptr<vector<vector<int>>>{};
+        return false;
     }
+    return true;
+}
+
+/**
+ * Generate a random maze using a chosen algorithm
+ * 
+ * @param algorithm algorithm to use for generation (dfs, kruskal, kruskal-parallel, prim,
+ *                  aldous-broder, wilson, aldous-broder-wilson, recursive-division, eller,
+ *                  sidewinder, binary-tree)
+ * @param random_start if true, uses random starting point, overriding startX and startY
+ *                     if applicable
+ * @param threads threads for the parallel algorithms and for tiles, 0 uses one per hardware thread
+ * @param tile_size if not 0, generate tiles of this many cells a side in parallel and stitch them
+ * @param seed seed of the generator, the same seed and arguments give the same maze
+ */
+unique_ptr<MazeGrid> generate_maze(size_t width, size_t height, string algorithm, size_t startX, 
+    size_t startY, bool random_start, bool show_frames, size_t threads, size_t tile_size, uint64_t seed) {
+    unique_ptr<MazeGrid> grid{new MazeGrid(width*2+1, height*2+1, 1)};
+    if (!generate_maze_into(*grid, algorithm, startX, startY, random_start, show_frames, threads, tile_size, 
+        seed))
+        return unique_ptr<MazeGrid>{};
+    return grid;
 }
 
 /**
- * Benchmark a maze generation algorithm
+ * Generate a random maze directly into the 2 bit per cell representation
  */
-unique_ptr<vector<vector<int>>> benchmark_maze(size_t width, size_t height, string algorithm, bool display, 
-    bool save, string file_path, bool save_binary) {
-    auto start = high_resolution_clock::now();
-    auto maze = generate_maze(width, height, algorithm);
-    auto stop = high_resolution_clock::now();
-    auto duration = duration_cast<microseconds>(stop - start);
-    if (display) display_maze(*maze);
-    if (save) save_maze(*maze, file_path, save_binary);
-    cout << algorithm << ": " << duration.count() << " microseconds\n";
+unique_ptr<PackedMaze> generate_packed_maze(size_t width, size_t height, string algorithm,
+    size_t startX, size_t startY, bool random_start, size_t threads, size_t tile_size, uint64_t seed) {
+    unique_ptr<PackedMaze> maze{new PackedMaze(width, height)};
+    if (!generate_maze_into(*maze, algorithm, startX, startY, random_start, false, threads, tile_size, seed))
+        return unique_ptr<PackedMaze>{};
     return maze;
 }
 
+/**
+ * Generate a maze into the legacy column-major nested vector layout (grid[x][y])
+ * Empty if the algorithm is invalid
+ */
+unique_ptr<vector<vector<int>>> generate_maze_nested(size_t width, size_t height, string algorithm,
+    size_t startX, size_t startY, bool random_start, bool show_frames, size_t threads, size_t tile_size,
+    uint64_t seed) {
+    auto grid = generate_maze(width, height, algorithm, startX, startY, random_start, show_frames, threads,
+        tile_size, seed);
+    if (!grid) return unique_ptr<vector<vector<int>>>();
+    return grid->to_nested();
+}
+
 /**
  * Initialize maze grid with walls between every element
  * Indices containing a 1 are walls
- * 
- * @param grid initialized with all 1's
  */
-void initialize_grid(vector<vector<int>>& grid) {
-    for (size_t i = 1; i < grid.size(); i+=2) {
-        for (size_t j = 1; j < grid[0].size(); j+=2) {
-            grid[i][j] = 0;
+void initialize_grid(MazeGrid& grid) {
+    grid.fill(1);
+    for (size_t j = 1; j < grid.height(); j+=2) {
+        uint8_t* row = grid.row(j);
+        for (size_t i = 1; i < grid.width(); i+=2) {
+            row[i] = 0;
         }
     }
 }
 
+void initialize_grid(PackedMaze& maze) {
+    maze.reset(true);
+}
+
 /**
- * Initialize maze grid with only walls along the border
- * 
- * @param grid initialized with all 0's
+ * Initialize maze grid with only walls along the border and the posts between walls
  */
-void initialize_grid_border(vector<vector<int>>& grid) {
-    for (size_t i = 0; i < grid.size(); ++i) {
-        grid[i][0] = 1;
-        grid[i][grid[0].size()-1] = 1;
+void initialize_grid_border(MazeGrid& grid) {
+    grid.fill(0);
+    for (size_t j = 2; j < grid.height(); j+=2) {
+        uint8_t* row = grid.row(j);
+        for (size_t i = 2; i < grid.width(); i+=2) {
+            row[i] = 1;
+        }
     }
-    for (size_t i = 0; i < grid[0].size(); ++i) {
-        grid[0][i] = 1;
-        grid[grid.size()-1][i] = 1;
+    for (size_t i = 0; i < grid.width(); ++i) {
+        grid(i, 0) = 1;
+        grid(i, grid.height()-1) = 1;
     }
+    for (size_t i = 0; i < grid.height(); ++i) {
+        grid(0, i) = 1;
+        grid(grid.width()-1, i) = 1;
+    }
+}
+
+void initialize_grid_border(PackedMaze& maze) {
+    maze.reset(false);
 }
 
+/**
+ * Lookup tables for picking among unvisited neighbors given as a 4-bit mask
+ * with bit i set if the neighbor in Direction i is unvisited
+ */
+struct neighbor_tables {
+    uint8_t count[16]; // number of set bits
+    uint8_t nth[16][4]; // direction of the n-th set bit
+    neighbor_tables() {
+        for (int mask = 0; mask < 16; ++mask) {
+            count[mask] = 0;
+            for (int dir = 0; dir < 4; ++dir) {
+                nth[mask][dir] = 0;
+                if (mask & (1 << dir)) nth[mask][count[mask]++] = (uint8_t) dir;
+            }
+        }
+    }
+};
+
 /**
  * Generate maze using depth-first search
+ * Visited cells are a flat bitset padded with a ring of visited cells, so the
+ * unvisited neighbors are found as a 4-bit mask without bounds checks or
+ * branches. Instead of a stack, every cell stores the 2-bit direction back to
+ * the cell it was entered from, and backtracking follows those directions.
  */
-unique_ptr<vector<vector<int>>> randomized_depth_first_search(size_t width, size_t height, 
-    size_t startX, size_t startY, bool random_start, bool show_frames) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-    std::uniform_int_distribution<> distr(0, 3); 
-    
+template <class Maze, class URNG>
+void carve_depth_first_search(Maze& maze, URNG& gen, size_t startX, size_t startY, bool random_start, 
+    bool show_frames) {
+    static const neighbor_tables tables;
+    size_t width = maze.cell_width(), height = maze.cell_height();
     if (random_start) {
         pair<size_t, size_t> start = random_coordinate(gen, width, height);
         startX = start.first;
         startY = start.second;
     }
 
-    vector<vector<int>>* grid = new vector<vector<int>>(width*2+1, vector<int>(height*2+1, 1));
-    initialize_grid(*grid);
-    vector<vector<bool>> visited(width, vector<bool>(height, false));
-    vector<pair<size_t, size_t>> stack;
-    
-    size_t maxX = width-1, maxY = height-1;
-    
-    pair<size_t, size_t> current;
-    stack.push_back(make_pair(startX, startY));
+    initialize_grid(maze);
+    // padded coordinates are shifted by 1 so the ring of border cells is at 0 and width+1
+    size_t padded_width = width + 2, padded_count = padded_width * (height + 2);
+    vector<std::uint64_t> visited((padded_count + 63) / 64, 0); // flat bitset
+    vector<uint8_t> backtrack((padded_count + 3) / 4, 0); // 2-bit direction to the previous cell
+    auto visit = [&](size_t cell) { visited[cell / 64] |= (std::uint64_t) 1 << (cell % 64); };
+    auto is_unvisited = [&](size_t cell) { return (std::uint32_t) (~visited[cell / 64] >> (cell % 64)) & 1; };
+    for (size_t i = 0; i < padded_width; ++i) {
+        visit(i);
+        visit(padded_count - 1 - i);
+    }
+    for (size_t j = 1; j <= height; ++j) {
+        visit(j * padded_width);
+        visit(j * padded_width + width + 1);
+    }
+    const long long offsets[] = {-1, -(long long) padded_width, 1, (long long) padded_width};
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
+
+    size_t x = startX, y = startY, current = (startY + 1) * padded_width + startX + 1;
+    const size_t start = current;
+    visit(current);
     
-    while (!stack.empty()) {
-        current = stack.back();
-        stack.pop_back();
-        // check the neighboring cells
-        size_t x = current.first, y = current.second;
-        // store coefficients to add for the neighbors
-        vector<pair<int, int>> unvisited_neighbors;
-        unvisited_neighbors.reserve(4);
-        if (x > 0 && !visited[x-1][y])
-            unvisited_neighbors.push_back(make_pair(-1,0));
-        if (x < maxX && !visited[x+1][y])
-            unvisited_neighbors.push_back(make_pair(1,0));
-        if (y > 0 && !visited[x][y-1])
-            unvisited_neighbors.push_back(make_pair(0,-1));
-        if (y < maxY && !visited[x][y+1])
-            unvisited_neighbors.push_back(make_pair(0,1));
-        if (unvisited_neighbors.size() > 0) {
-            // choose random neighbor
-            int choice = distr(gen);
-            while (choice >= (int)unvisited_neighbors.size())
-                choice = distr(gen);
-            pair<int, int> neighbor = unvisited_neighbors[choice];
-            // perform operations on chosen neighbor
-            stack.push_back(current);
-            size_t gridX = (size_t)(2*x+1), gridY = (size_t)(2*y+1);
-            (*grid)[gridX+neighbor.first][gridY+neighbor.second] = 0;
-            visited[x+neighbor.first][y+neighbor.second] = true; 
-            stack.push_back(make_pair(x+neighbor.first,y+neighbor.second));
+    while (true) {
+        std::uint32_t unvisited = is_unvisited(current - 1) | is_unvisited(current - padded_width) << 1
+            | is_unvisited(current + 1) << 2 | is_unvisited(current + padded_width) << 3;
+        if (unvisited == 0) { // backtrack
+            if (current == start) break;
+            Direction back = (Direction) ((backtrack[current / 4] >> ((current % 4) * 2)) & 3);
+            x += dx[back], y += dy[back], current += offsets[back];
+            continue;
         }
-        if (show_frames) display_maze(*grid);
+        // choose random neighbor
+        std::uint32_t count = tables.count[unvisited];
+        Direction neighbor = (Direction) tables.nth[unvisited][count == 1 ? 0 : bounded_draw(gen, count)];
+        maze.open_wall(x, y, neighbor);
+        x += dx[neighbor], y += dy[neighbor], current += offsets[neighbor];
+        visit(current);
+        backtrack[current / 4] |= (uint8_t) (((neighbor + 2) % 4) << ((current % 4) * 2));
+        if (show_frames) display_frame(maze);
     }
-    return unique_ptr<vector<vector<int>>>{grid};
+    if (show_frames) display_last_frame(maze);
+}
+
+unique_ptr<MazeGrid> randomized_depth_first_search(size_t width, size_t height, 
+    size_t startX, size_t startY, bool random_start, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_depth_first_search(*grid, gen, startX, startY, random_start, show_frames);
+    return unique_ptr<MazeGrid>{grid};
 }
 
 /**
- * Initialize grid for kruskal
- * Grid does not have boundaries yet
+ * Initialize walls for kruskal
+ * Each wall is stored as 2 * cell index + 0 for the east wall or + 1 for the
+ * south wall of that cell, with cells indexed row-major
  */
-void initialize_kruskal(union_find_forest<pair<size_t,size_t>>& cells, 
-    vector<pair<size_t, size_t>>& walls, size_t width, size_t height) {
-    for (size_t i = 0; i < width; ++i) {
-        for (size_t j = 0; j < height; ++j) {
-            pair<size_t, size_t> cell(i, j);
-            size_t cell_index = cells.size(); // indexed as if it were 1D array
-            cells.insert(cell);
-            if (i > 0) { // neighbor at i - 1
-                size_t neighbor_index = cell_index - height;
-                walls.push_back(make_pair(neighbor_index, cell_index));
-            }
-            if (j > 0) { // neighbor at j - 1
-                size_t neighbor_index = cell_index - 1;
-                walls.push_back(make_pair(neighbor_index, cell_index));
-            }
+template <class Index>
+void initialize_kruskal(vector<Index>& walls, size_t width, size_t height) {
+    for (size_t j = 0; j < height; ++j) {
+        for (size_t i = 0; i < width; ++i) {
+            Index cell_index = (Index) (j * width + i);
+            if (i + 1 < width) walls.push_back(2 * cell_index);
+            if (j + 1 < height) walls.push_back(2 * cell_index + 1);
         }
     }
 }
 
 /**
- * Generate maze using Kruskal's algorithm
+ * Run Kruskal's algorithm with cell and wall indices of the given width
  */
-unique_ptr<vector<vector<int>>> kruskal(size_t width, size_t height, bool show_frames) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-
-    union_find_forest<pair<size_t,size_t>> cells(width*height); // disjoint set data structure
-    vector<pair<size_t,size_t>> walls; // edges, stores pairs of cell indices
-    walls.reserve(2*width*height-width-height); // width*(height-1)+(width-1)*height
-    initialize_kruskal(cells, walls, width, height);
-    shuffle(walls.begin(), walls.end(), gen); // randomize wall order
+template <class Index, class Maze, class URNG>
+void kruskal_walls(Maze& maze, URNG& gen, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    disjoint_set<Index> cells(width*height); // disjoint set data structure
+    vector<Index> walls; // edges, see initialize_kruskal
+    walls.reserve(2*width*height); // width*(height-1)+(width-1)*height is always less
+    initialize_kruskal(walls, width, height);
+    shuffle_range(walls.begin(), walls.end(), gen); // randomize wall order
     
-    vector<vector<int>>* grid = new vector<vector<int>>(width*2+1, vector<int>(height*2+1, 1));
-    initialize_grid(*grid);
+    initialize_grid(maze);
     
     for (size_t i = 0; i < walls.size(); ++i) {
-        size_t a = walls[i].first, b = walls[i].second;
-        if (cells.union_sets(a, b)) { // remove walls from grid given successful union
-            if (cells[a].first < cells[b].first)
-                (*grid)[cells[a].first*2+2][cells[a].second*2+1] = 0;
-            else if (cells[a].second < cells[b].second)
-                (*grid)[cells[a].first*2+1][cells[a].second*2+2] = 0;
+        Index a = walls[i] / 2;
+        bool south = walls[i] % 2 == 1;
+        Index b = south ? a + (Index) width : a + 1;
+        if (cells.union_unchecked(a, b)) { // remove walls from grid given successful union
+            size_t y = a / width;
+            maze.open_wall(a - y * width, y, south ? SOUTH : EAST);
         }
-        if (show_frames) display_maze(*grid);
+        if (show_frames) display_frame(maze);
     }
-    return unique_ptr<vector<vector<int>>>{grid};
 }
 
-template <class URNG>
-void prim_random_insert(list<size_t>& walls, URNG& gen, size_t value) {
-    if (walls.size() > 0) {
-        std::uniform_int_distribution<> distr(0, walls.size()-1);
-        list<size_t>::iterator position = walls.begin();
-        int choice = distr(gen);
-        std::advance(position, choice);
-        walls.insert(position, value);
+/**
+ * Generate maze using Kruskal's algorithm
+ * Uses 32-bit indices unless the maze has too many walls for them
+ */
+template <class Maze, class URNG>
+void carve_kruskal(Maze& maze, URNG& gen, bool show_frames) {
+    if (2 * maze.cell_width() * maze.cell_height() <= std::numeric_limits<std::uint32_t>::max())
+        kruskal_walls<std::uint32_t>(maze, gen, show_frames);
+    else
+        kruskal_walls<std::uint64_t>(maze, gen, show_frames);
+    if (show_frames) display_last_frame(maze);
+}
+
+unique_ptr<MazeGrid> kruskal(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_kruskal(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Atomically lower a reservation to the given priority
+ */
+template <class Index>
+void reserve_min(std::atomic<Index>& reservation, Index priority) {
+    Index current = reservation.load(std::memory_order_relaxed);
+    while (priority < current && !reservation.compare_exchange_weak(current, priority, 
+        std::memory_order_relaxed)) {}
+}
+
+/**
+ * Run Kruskal's algorithm over the shuffled walls on several threads
+ * 
+ * Walls are processed in batches using deterministic reservations: in the
+ * reserve phase every wall finds the roots of its two cells and writes its
+ * position in the shuffled order into both roots with an atomic min, and in
+ * the commit phase a wall that holds the reservation on one of its roots
+ * links that root to the other. Walls that lose both reservations are retried
+ * in the next batch. A wall only joins two sets if no earlier wall did, so
+ * the opened walls are exactly the ones sequential Kruskal would open for the
+ * same shuffled order, and the maze has the same distribution.
+ */
+template <class Index, class Maze, class URNG>
+void kruskal_parallel_walls(Maze& maze, URNG& gen, size_t threads, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    size_t cell_count = width*height;
+    vector<Index> walls; // edges, see initialize_kruskal
+    walls.reserve(2*cell_count);
+    initialize_kruskal(walls, width, height);
+    shuffle_range(walls.begin(), walls.end(), gen); // randomize wall order, position is the priority
+
+    initialize_grid(maze);
+
+    concurrent_disjoint_set<Index> cells(cell_count);
+    const Index unreserved = std::numeric_limits<Index>::max();
+    unique_ptr<std::atomic<Index>[]> reservations(new std::atomic<Index>[cell_count]);
+    for (size_t i = 0; i < cell_count; ++i) reservations[i].store(unreserved, std::memory_order_relaxed);
+
+    size_t batch_size = std::max((size_t) 4096 * threads, walls.size() / 64);
+    vector<Index> batch; // positions in walls of the current batch
+    vector<Index> roots; // roots of both cells of each wall in the batch
+    vector<uint8_t> done; // wall in the batch was opened or joins cells already connected
+    vector<vector<Index>> opened(threads); // walls opened by each thread in the current batch
+    batch.reserve(batch_size);
+    size_t next = 0, opened_count = 0;
+    bool finished = false;
+    thread_barrier barrier(threads);
+
+    auto reserve = [&](size_t t) {
+        size_t lo = batch.size() * t / threads, hi = batch.size() * (t + 1) / threads;
+        for (size_t k = lo; k < hi; ++k) {
+            Index wall = walls[batch[k]];
+            Index a = wall / 2, b = wall % 2 == 1 ? a + (Index) width : a + 1;
+            Index u = cells.find(a), v = cells.find(b);
+            roots[2*k] = u;
+            roots[2*k+1] = v;
+            done[k] = u == v;
+            if (!done[k]) {
+                reserve_min(reservations[u], batch[k]);
+                reserve_min(reservations[v], batch[k]);
+            }
+        }
+    };
+    auto commit = [&](size_t t) {
+        size_t lo = batch.size() * t / threads, hi = batch.size() * (t + 1) / threads;
+        for (size_t k = lo; k < hi; ++k) {
+            if (done[k]) continue;
+            Index u = roots[2*k], v = roots[2*k+1], position = batch[k];
+            bool holds_u = reservations[u].load(std::memory_order_relaxed) == position;
+            bool holds_v = reservations[v].load(std::memory_order_relaxed) == position;
+            if (!holds_u && !holds_v) continue;
+            if (holds_u) cells.link(u, v);
+            else cells.link(v, u);
+            if (holds_u) reservations[u].store(unreserved, std::memory_order_relaxed);
+            if (holds_v) reservations[v].store(unreserved, std::memory_order_relaxed);
+            opened[t].push_back(walls[position]);
+            done[k] = 1;
+        }
+    };
+    auto worker = [&](size_t t) {
+        while (true) {
+            barrier.wait(); // wait for the next batch
+            if (finished) return;
+            reserve(t);
+            barrier.wait();
+            commit(t);
+            barrier.wait();
+        }
+    };
+
+    vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t) workers.push_back(std::thread(worker, t));
+    while (true) {
+        // keep the walls that lost their reservations and fill up with new ones
+        size_t kept = 0;
+        for (size_t k = 0; k < batch.size(); ++k)
+            if (!done[k]) batch[kept++] = batch[k];
+        batch.resize(kept);
+        while (batch.size() < batch_size && next < walls.size()) batch.push_back((Index) next++);
+        roots.resize(2*batch.size());
+        done.assign(batch.size(), 0);
+        finished = batch.empty() || opened_count + 1 >= cell_count;
+
+        barrier.wait();
+        if (finished) break;
+        reserve(0);
+        barrier.wait();
+        commit(0);
+        barrier.wait();
+
+        for (size_t t = 0; t < threads; ++t) {
+            for (size_t i = 0; i < opened[t].size(); ++i) {
+                Index cell = opened[t][i] / 2;
+                size_t y = cell / width;
+                maze.open_wall(cell - y * width, y, opened[t][i] % 2 == 1 ? SOUTH : EAST);
+            }
+            opened_count += opened[t].size();
+            opened[t].clear();
+        }
+        if (show_frames) display_frame(maze);
     }
-    else walls.push_front(value);
+    for (size_t t = 0; t < workers.size(); ++t) workers[t].join();
 }
 
 /**
- * Add current cell's walls to the set
+ * Generate maze using Kruskal's algorithm on multiple threads
  * 
- * @param position random position to insert in at list
+ * @param threads number of threads, 0 uses one per hardware thread
  */
-template <class URNG>
-void prim_add_walls(vector<vector<int>>& grid, list<size_t>& walls, URNG& gen, 
-    size_t grid_width, size_t grid_height, size_t x, size_t y) {
-    if (x > 1 && grid[x-2][y] == 1)
-        prim_random_insert(walls, gen, grid_width*(x - 1) + y);
-    if (y > 1 && grid[x][y-2] == 1)
-        prim_random_insert(walls, gen, grid_width*(x) + y - 1);
-    if (x < grid_width-2 && grid[x+2][y] == 1)
-        prim_random_insert(walls, gen, grid_width*(x + 1) + y);
-    if (y < grid_height-2 && grid[x][y+2] == 1)
-        prim_random_insert(walls, gen, grid_width*(x) + y + 1);
-    grid[x][y] = 0; // mark the cell as visited
+template <class Maze, class URNG>
+void carve_kruskal_parallel(Maze& maze, URNG& gen, size_t threads, bool show_frames) {
+    threads = resolve_thread_count(threads);
+    if (2 * maze.cell_width() * maze.cell_height() < std::numeric_limits<std::uint32_t>::max())
+        kruskal_parallel_walls<std::uint32_t>(maze, gen, threads, show_frames);
+    else
+        kruskal_parallel_walls<std::uint64_t>(maze, gen, threads, show_frames);
+    if (show_frames) display_last_frame(maze);
+}
+
+unique_ptr<MazeGrid> kruskal_parallel(size_t width, size_t height, size_t threads, bool show_frames,
+    uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_kruskal_parallel(*grid, gen, threads, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Add current cell's walls to the frontier and mark it as visited
+ * Walls are stored as 4 * cell index + direction
+ */
+void prim_add_walls(vector<bool>& visited, vector<size_t>& walls, 
+    size_t width, size_t height, size_t x, size_t y) {
+    size_t cell = y * width + x;
+    if (x > 0 && !visited[cell - 1])
+        walls.push_back(4 * cell + WEST);
+    if (y > 0 && !visited[cell - width])
+        walls.push_back(4 * cell + NORTH);
+    if (x < width-1 && !visited[cell + 1])
+        walls.push_back(4 * cell + EAST);
+    if (y < height-1 && !visited[cell + width])
+        walls.push_back(4 * cell + SOUTH);
+    visited[cell] = true;
 } 
 
 /**
  * Generate maze using Prim's algorithm
+ * Each step removes a uniformly random wall from the frontier by swapping it
+ * with the last one and popping, and opens it if the cell behind it is not
+ * yet in the maze. Membership in the maze is a bitset, so stale frontier walls
+ * are dropped in O(1) when drawn.
  */
-unique_ptr<vector<vector<int>>> prim(size_t width, size_t height, 
-    size_t startX, size_t startY, bool random_start, bool show_frames) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-    std::uniform_int_distribution<> distr(0, 3);
-
+template <class Maze, class URNG>
+void carve_prim(Maze& maze, URNG& gen, size_t startX, size_t startY, bool random_start, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
     if (random_start) {
         pair<size_t, size_t> start = random_coordinate(gen, width, height);
         startX = start.first;
         startY = start.second;
     }
 
-    list<size_t> walls; // edges, stored as grid indices mapped to 1D
-    size_t grid_width = width*2+1, grid_height = height*2+1;
-    vector<vector<int>>* grid = new vector<vector<int>>(grid_width, vector<int>(grid_height, 1));
+    initialize_grid(maze);
+    vector<size_t> walls; // frontier, edges between a visited cell and an unvisited neighbor
+    vector<bool> visited(width*height, false); // bitset of cells already in the maze
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
 
-    prim_add_walls(*grid, walls, gen, grid_width, grid_height, 2*startX+1, 2*startY+1); // starting pt
+    prim_add_walls(visited, walls, width, height, startX, startY); // starting pt
 
-    while (walls.size() > 0) {
-        size_t current_wall = *(walls.begin());
-        size_t wall_x = current_wall / grid_width; // essentially floored
-        size_t wall_y = current_wall - (wall_x * grid_width);
-        if (wall_x % 2 == 0) { // vertical wall 
-            if ((*grid)[wall_x - 1][wall_y] == 1 && (*grid)[wall_x + 1][wall_y] == 0) {
-                prim_add_walls(*grid, walls, gen, grid_width, grid_height, wall_x-1, wall_y);
-                (*grid)[wall_x][wall_y] = 0;
-            }
-            else if ((*grid)[wall_x + 1][wall_y] == 1 && (*grid)[wall_x - 1][wall_y] == 0){
-                prim_add_walls(*grid, walls, gen, grid_width, grid_height, wall_x+1, wall_y);
-                (*grid)[wall_x][wall_y] = 0;
-            }
+    while (!walls.empty()) {
+        size_t choice = (size_t) bounded_draw64(gen, walls.size());
+        size_t current_wall = walls[choice];
+        walls[choice] = walls.back();
+        walls.pop_back();
+
+        size_t cell = current_wall / 4;
+        Direction dir = (Direction) (current_wall % 4);
+        size_t y = cell / width; // essentially floored
+        size_t x = cell - (y * width);
+        size_t next_x = x + dx[dir], next_y = y + dy[dir];
+        if (!visited[next_y * width + next_x]) {
+            maze.open_wall(x, y, dir);
+            prim_add_walls(visited, walls, width, height, next_x, next_y);
+            if (show_frames) display_frame(maze);
         }
-        else { // horizontal wall
-            if ((*grid)[wall_x][wall_y - 1] == 1 && (*grid)[wall_x][wall_y + 1] == 0) {
-                prim_add_walls(*grid, walls, gen, grid_width, grid_height, wall_x, wall_y-1);
-                (*grid)[wall_x][wall_y] = 0;
-            }
-            else if ((*grid)[wall_x][wall_y + 1] == 1 && (*grid)[wall_x][wall_y - 1] == 0){
-                prim_add_walls(*grid, walls, gen, grid_width, grid_height, wall_x, wall_y+1);
-                (*grid)[wall_x][wall_y] = 0;
+    }
+    if (show_frames) display_last_frame(maze);
+}
+
+unique_ptr<MazeGrid> prim(size_t width, size_t height, 
+    size_t startX, size_t startY, bool random_start, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_prim(*grid, gen, startX, startY, random_start, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Random walk of Aldous-Broder, opening the wall into every cell the first time
+ * it is entered
+ * 
+ * @param visited cells already in the maze, the walk starts at start_cell
+ * @param unvisited_count number of cells not in the maze, updated by the walk
+ * @param stop_count stop once this many cells are left unvisited
+ */
+template <class Maze, class URNG>
+void aldous_broder_walk(Maze& maze, URNG& gen, vector<bool>& visited, size_t start_cell,
+    size_t& unvisited_count, size_t stop_count, bool show_frames) {
+    random_bits<URNG> directions(gen);
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
+
+    pair<size_t, size_t> current(start_cell % width, start_cell / width);
+    while (unvisited_count > stop_count) {
+        Direction dir = (Direction) directions.next(2);
+        long long tmp_x = (long long) current.first + dx[dir], tmp_y = (long long) current.second + dy[dir];
+        if (tmp_x >= 0 && (size_t)tmp_x < width && tmp_y >= 0 && (size_t)tmp_y < height) {
+            size_t next = (size_t) tmp_y * width + (size_t) tmp_x;
+            if (!visited[next]) {
+                maze.open_wall(current.first, current.second, dir);
+                visited[next] = true;
+                unvisited_count--;
             }
+            current.first = tmp_x, current.second = tmp_y;
+        }
+        if (show_frames) display_frame(maze);
+    }
+}
+
+/**
+ * Loop-erased random walks of Wilson's algorithm
+ * From every cell not yet in the maze, walks randomly until it hits the maze,
+ * remembering only the last direction taken out of each cell, so loops are
+ * erased by being overwritten. The walk is then retraced and added to the maze.
+ * 
+ * @param in_maze cells already in the maze, must contain at least one cell
+ */
+template <class Maze, class URNG>
+void wilson_walks(Maze& maze, URNG& gen, vector<bool>& in_maze, bool show_frames) {
+    random_bits<URNG> random_directions(gen);
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    const long long offsets[] = {-1, -(long long) width, 1, (long long) width}; // index offsets
+    vector<uint8_t> directions(width*height); // last direction taken out of each cell
+
+    for (size_t start = 0; start < width*height; ++start) {
+        if (in_maze[start]) continue;
+        // walk until reaching the maze
+        size_t current = start;
+        while (!in_maze[current]) {
+            size_t y = current / width, x = current - y * width;
+            Direction dir = (Direction) random_directions.next(2);
+            if ((dir == WEST && x == 0) || (dir == NORTH && y == 0) 
+                || (dir == EAST && x + 1 == width) || (dir == SOUTH && y + 1 == height)) continue;
+            directions[current] = dir;
+            current += offsets[dir];
         }
-        walls.pop_front();
-        if (show_frames) display_maze(*grid);
+        // retrace the loop-erased walk into the maze
+        current = start;
+        while (!in_maze[current]) {
+            size_t y = current / width, x = current - y * width;
+            Direction dir = (Direction) directions[current];
+            maze.open_wall(x, y, dir);
+            in_maze[current] = true;
+            current += offsets[dir];
+        }
+        if (show_frames) display_frame(maze);
     }
-    return unique_ptr<vector<vector<int>>>{grid};
 }
 
 /**
  * Generate maze using Aldous-Broder algorithm
  */
-unique_ptr<vector<vector<int>>> aldous_broder(size_t width, size_t height, bool show_frames) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-    std::uniform_int_distribution<> distr(0, 3); 
+template <class Maze, class URNG>
+void carve_aldous_broder(Maze& maze, URNG& gen, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    initialize_grid(maze);
+    vector<bool> visited(width*height, false);
+    size_t unvisited_count = width*height - 1; // start with 1 visited at the start
+
+    pair<size_t, size_t> current = random_coordinate(gen, width, height);
+    size_t start = current.second * width + current.first;
+    visited[start] = true;
+    aldous_broder_walk(maze, gen, visited, start, unvisited_count, 0, show_frames);
+    if (show_frames) display_last_frame(maze);
+}
 
-    size_t grid_width = width*2+1, grid_height = height*2+1;
-    vector<vector<int>>* grid = new vector<vector<int>>(grid_width, vector<int>(grid_height, 1));
+/**
+ * Generate maze using Wilson's algorithm
+ * Produces the same uniform spanning tree distribution as Aldous-Broder
+ * without its long cover time
+ */
+template <class Maze, class URNG>
+void carve_wilson(Maze& maze, URNG& gen, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    initialize_grid(maze);
+    vector<bool> in_maze(width*height, false);
+    pair<size_t, size_t> root = random_coordinate(gen, width, height);
+    in_maze[root.second * width + root.first] = true;
+    wilson_walks(maze, gen, in_maze, show_frames);
+    if (show_frames) display_last_frame(maze);
+}
 
-    pair<int, int> neighbor_offsets[] = {{-2, 0}, {2, 0}, {0, -2}, {0, 2}}; // offset wrt the grid coords
+/**
+ * Generate maze using Aldous-Broder until a fraction of the cells are visited,
+ * then finish with Wilson's algorithm from the visited cells
+ * Aldous-Broder is fast while most cells are unvisited and Wilson's is fast once
+ * the maze is large, and the result is still a uniform spanning tree
+ * 
+ * @param coverage fraction of cells to visit with Aldous-Broder
+ */
+template <class Maze, class URNG>
+void carve_aldous_broder_wilson(Maze& maze, URNG& gen, double coverage, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    initialize_grid(maze);
+    vector<bool> visited(width*height, false);
     size_t unvisited_count = width*height - 1; // start with 1 visited at the start
+    size_t stop_count = (size_t) ((1.0 - std::min(std::max(coverage, 0.0), 1.0)) * width * height);
 
-    pair<size_t, size_t> current = random_maze_coordinate(gen, width, height);
-    (*grid)[current.first][current.second] = 0;
-
-    while (unvisited_count > 0) {
-        pair<int, int> offset = neighbor_offsets[distr(gen)]; 
-        int tmp_x = current.first + offset.first, tmp_y = current.second + offset.second;
-        if (tmp_x > 0 && (size_t)tmp_x < grid_width - 1 
-            && tmp_y > 0 && (size_t)tmp_y < grid_height - 1) {
-            if ((*grid)[tmp_x][tmp_y] == 1) {
-                (*grid)[current.first + offset.first / 2][current.second + offset.second / 2] = 0;
-                (*grid)[tmp_x][tmp_y] = 0;
-                unvisited_count--;
+    pair<size_t, size_t> current = random_coordinate(gen, width, height);
+    size_t start = current.second * width + current.first;
+    visited[start] = true;
+    aldous_broder_walk(maze, gen, visited, start, unvisited_count, stop_count, show_frames);
+    wilson_walks(maze, gen, visited, show_frames);
+    if (show_frames) display_last_frame(maze);
+}
+
+unique_ptr<MazeGrid> aldous_broder(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_aldous_broder(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+unique_ptr<MazeGrid> wilson(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_wilson(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+unique_ptr<MazeGrid> aldous_broder_wilson(size_t width, size_t height, double coverage, bool show_frames,
+    uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_aldous_broder_wilson(*grid, gen, coverage, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Rectangle of cells still to be divided by recursive division
+ */
+struct chamber {
+    size_t x;
+    size_t y;
+    size_t width;
+    size_t height;
+};
+
+/**
+ * Only MazeGrid gives every wall its own byte, so only it can be divided by
+ * several threads at once
+ */
+bool supports_concurrent_walls(const MazeGrid&) { return true; }
+bool supports_concurrent_walls(const PackedMaze&) { return false; }
+
+/**
+ * Divide a chamber and all of its sub-chambers with an explicit stack
+ * Each division closes one row or column of walls across the chamber, leaving
+ * one passage, and splits it in two. Sub-chambers of at least task_threshold
+ * cells are handed to the pool when there is one.
+ */
+template <class Maze, class URNG>
+void divide_chambers(Maze& maze, URNG& gen, chamber start, work_stealing_pool* pool, 
+    size_t task_threshold, bool show_frames) {
+    vector<chamber> stack;
+    stack.push_back(start);
+    while (!stack.empty()) {
+        chamber current = stack.back();
+        stack.pop_back();
+        if (current.width < 2 || current.height < 2) continue; // corridors are already perfect
+        bool horizontal = current.height > current.width 
+            || (current.height == current.width && (gen() & 1) == 0);
+        chamber halves[2];
+        if (horizontal) { // close the south walls of one row
+            size_t row = current.y + (size_t) bounded_draw64(gen, current.height-1);
+            size_t passage = current.x + (size_t) bounded_draw64(gen, current.width);
+            for (size_t i = current.x; i < current.x + current.width; ++i)
+                if (i != passage) maze.close_wall(i, row, SOUTH);
+            halves[0] = {current.x, current.y, current.width, row - current.y + 1};
+            halves[1] = {current.x, row + 1, current.width, current.y + current.height - row - 1};
+        }
+        else { // close the east walls of one column
+            size_t column = current.x + (size_t) bounded_draw64(gen, current.width-1);
+            size_t passage = current.y + (size_t) bounded_draw64(gen, current.height);
+            for (size_t j = current.y; j < current.y + current.height; ++j)
+                if (j != passage) maze.close_wall(column, j, EAST);
+            halves[0] = {current.x, current.y, column - current.x + 1, current.height};
+            halves[1] = {column + 1, current.y, current.x + current.width - column - 1, current.height};
+        }
+        if (show_frames) display_frame(maze);
+        for (size_t i = 0; i < 2; ++i) {
+            chamber half = halves[i];
+            if (pool != nullptr && half.width * half.height >= task_threshold) {
+                typename URNG::result_type seed = gen();
+                pool->submit([&maze, half, pool, task_threshold, seed]() {
+                    URNG half_gen(seed);
+                    divide_chambers(maze, half_gen, half, pool, task_threshold, false);
+                });
             }
-            current.first = tmp_x, current.second = tmp_y;
+            else stack.push_back(half);
         }
-        if (show_frames) display_maze(*grid);
     }
-    return unique_ptr<vector<vector<int>>>{grid};
 }
 
 /**
- * One step of recursive division
+ * Generate maze using Recursive Division method
  * 
- * @param x x coord of top right corner of chamber
- * @param y y coord of top right corner of chamber
- * @param width width of chamber
- * @param height height of chamber
+ * @param threads threads to divide independent sub-chambers on, 0 uses one per
+ *                hardware thread. Frames and packed mazes are always divided on one thread.
  */
-template <class URNG>
-void divide_chamber(vector<vector<int>>& grid, URNG& gen, size_t x, size_t y,
-    size_t width, size_t height, bool show_frames) {
-    if (width > 1 && height > 1) {
-        std::uniform_int_distribution<> x_distr(0, width-1); 
-        std::uniform_int_distribution<> y_distr(0, height-1);
-        size_t x_pass = x_distr(gen) + x;
-        size_t y_pass = y_distr(gen) + y;
-
-        pair<size_t, size_t> wall_coord = random_maze_coordinate(gen, width-1, height-1);
-        wall_coord.first++;
-        wall_coord.second++;
-        
-        // create the two chamber divisions
-        for (size_t i = 0; i < width; ++i) {
-            grid[i + x][y + wall_coord.second] = 1;
-        }
-        for (size_t i = 0; i < height; ++i) {
-            grid[x + wall_coord.first][i + y] = 1;
+template <class Maze, class URNG>
+void carve_recursive_division(Maze& maze, URNG& gen, size_t threads, bool show_frames) {
+    initialize_grid_border(maze);
+    chamber whole = {0, 0, maze.cell_width(), maze.cell_height()};
+    threads = resolve_thread_count(threads);
+    if (threads == 1 || show_frames || !supports_concurrent_walls(maze)) {
+        divide_chambers(maze, gen, whole, nullptr, 0, show_frames);
+        if (show_frames) display_last_frame(maze);
+        return;
+    }
+    const size_t task_threshold = 64 * 64; // smaller chambers are not worth a task
+    work_stealing_pool pool(threads);
+    divide_chambers(maze, gen, whole, &pool, task_threshold, false);
+    pool.wait();
+}
+
+unique_ptr<MazeGrid> recursive_division(size_t width, size_t height, bool show_frames, size_t threads,
+    uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 0);
+    xoshiro256 gen(seed);
+    carve_recursive_division(*grid, gen, threads, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Copy the rows of a MazeRowStream into a maze, setting every inner wall
+ */
+template <class Maze, class URNG>
+static void carve_rows(Maze& maze, URNG& gen, string algorithm, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    unique_ptr<MazeRowStream> stream = MazeRowStream::create(width, height, algorithm, random_bits64(gen));
+    if (!stream) return;
+    initialize_grid(maze);
+    vector<uint8_t> east_walls(width), south_walls(width);
+    for (size_t y = 0; stream->next_row(east_walls.data(), south_walls.data()); ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            if (x + 1 < width) {
+                if (east_walls[x]) maze.close_wall(x, y, EAST);
+                else maze.open_wall(x, y, EAST);
+            }
+            if (y + 1 < height) {
+                if (south_walls[x]) maze.close_wall(x, y, SOUTH);
+                else maze.open_wall(x, y, SOUTH);
+            }
         }
+        if (show_frames) display_frame(maze);
+    }
+    if (show_frames) display_last_frame(maze);
+}
 
-        // set the passages
-        grid[x_pass][y + wall_coord.second] = 0;
-        grid[x + wall_coord.first][y_pass] = 0;
+/**
+ * Generate maze using Eller's algorithm, one row at a time
+ */
+template <class Maze, class URNG>
+void carve_eller(Maze& maze, URNG& gen, bool show_frames) {
+    carve_rows(maze, gen, "eller", show_frames);
+}
 
-        if (show_frames) display_maze(grid);
-    }   
+/**
+ * Generate maze using the sidewinder algorithm, one row at a time
+ */
+template <class Maze, class URNG>
+void carve_sidewinder(Maze& maze, URNG& gen, bool show_frames) {
+    carve_rows(maze, gen, "sidewinder", show_frames);
 }
 
 /**
- * Generate maze using Recursive Division method
+ * Generate maze using the binary tree algorithm, one row at a time
+ */
+template <class Maze, class URNG>
+void carve_binary_tree(Maze& maze, URNG& gen, bool show_frames) {
+    carve_rows(maze, gen, "binary-tree", show_frames);
+}
+
+unique_ptr<MazeGrid> eller(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_eller(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+unique_ptr<MazeGrid> sidewinder(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_sidewinder(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+unique_ptr<MazeGrid> binary_tree(size_t width, size_t height, bool show_frames, uint64_t seed) {
+    MazeGrid* grid = new MazeGrid(width*2+1, height*2+1, 1);
+    xoshiro256 gen(seed);
+    carve_binary_tree(*grid, gen, show_frames);
+    return unique_ptr<MazeGrid>{grid};
+}
+
+/**
+ * Generate a maze as independent square tiles on several threads, then stitch them
+ * Every tile is generated with the algorithm into its own packed buffer from
+ * its own seed. The tiles are copied into the maze by chunks of rows starting
+ * at multiples of 4, so no two threads write the same byte of a packed maze.
+ * A random spanning tree over the tiles then picks which neighboring tiles
+ * are joined, and each of its edges opens one random wall on their shared
+ * border. Every tile is a spanning tree of its cells, so the result is a
+ * perfect maze, although the tile borders show as long straight walls.
+ *
+ * @param tile_size cells on a side of a tile, the last row and column of tiles may be smaller
+ * @param threads threads to generate and copy tiles on, 0 uses one per hardware thread
  */
-unique_ptr<vector<vector<int>>> recursive_division(size_t width, size_t height, bool show_frames) {
-    std::random_device rd; // obtain a random number from hardware
-    std::mt19937 gen(rd()); // seed the generator
-    std::uniform_int_distribution<> distr(0, 3); 
+template <class Maze, class URNG>
+void carve_tiled(Maze& maze, URNG& gen, string algorithm, size_t tile_size, size_t threads, bool show_frames) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    if (width == 0 || height == 0) return;
+    tile_size = std::max(tile_size, (size_t) 1);
+    size_t columns = (width + tile_size - 1) / tile_size, rows = (height + tile_size - 1) / tile_size;
+    size_t tile_count = columns * rows;
+    vector<uint64_t> seeds(tile_count); // drawn up front so the maze does not depend on scheduling
+    for (size_t t = 0; t < tile_count; ++t) seeds[t] = random_bits64(gen);
 
-    size_t grid_width = width*2+1, grid_height = height*2+1;
-    vector<vector<int>>* grid = new vector<vector<int>>(grid_width, vector<int>(grid_height, 0));
-    initialize_grid_border(*grid);
+    vector<PackedMaze> tiles(tile_count);
+    work_stealing_pool pool(threads);
+    for (size_t t = 0; t < tile_count; ++t) {
+        pool.submit([&, t]() {
+            size_t tx = t % columns, ty = t / columns;
+            tiles[t].resize(std::min(tile_size, width - tx * tile_size), 
+                std::min(tile_size, height - ty * tile_size));
+            generate_maze_into(tiles[t], algorithm, 0, 0, true, false, 1, 0, seeds[t]);
+        });
+    }
+    pool.wait();
 
-    size_t chamber_width = grid_width - 2, chamber_height = grid_height - 2;
-    divide_chamber(*grid, gen, 1, 1, chamber_width, chamber_height, show_frames);
+    initialize_grid(maze);
+    size_t chunk_rows = std::max((size_t) 4, (height / (4 * pool.size()) + 3) / 4 * 4);
+    for (size_t first = 0; first < height; first += chunk_rows) {
+        pool.submit([&, first]() {
+            for (size_t y = first; y < std::min(first + chunk_rows, height); ++y) {
+                size_t ty = y / tile_size, ly = y - ty * tile_size;
+                for (size_t tx = 0; tx < columns; ++tx) {
+                    const PackedMaze& tile = tiles[ty * columns + tx];
+                    size_t x = tx * tile_size;
+                    for (size_t lx = 0; lx < tile.cell_width(); ++lx, ++x) {
+                        if (lx + 1 < tile.cell_width() && !tile.has_wall(lx, ly, EAST)) maze.open_wall(x, y, EAST);
+                        if (ly + 1 < tile.cell_height() && !tile.has_wall(lx, ly, SOUTH)) maze.open_wall(x, y, SOUTH);
+                    }
+                }
+            }
+        });
+    }
+    pool.wait();
 
-    return unique_ptr<vector<vector<int>>>{grid};
+    // stitch along a random spanning tree of the tiles, edges are 2 * tile + 0 for east or + 1 for south
+    vector<size_t> edges;
+    for (size_t t = 0; t < tile_count; ++t) {
+        if (t % columns + 1 < columns) edges.push_back(2 * t);
+        if (t / columns + 1 < rows) edges.push_back(2 * t + 1);
+    }
+    shuffle_range(edges.begin(), edges.end(), gen);
+    disjoint_set<std::uint64_t> joined(tile_count);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        size_t t = edges[i] / 2;
+        bool south = edges[i] % 2 == 1;
+        if (!joined.union_unchecked(t, south ? t + columns : t + 1)) continue;
+        size_t tx = t % columns, ty = t / columns;
+        if (south) {
+            size_t x = tx * tile_size + (size_t) bounded_draw64(gen, tiles[t].cell_width());
+            maze.open_wall(x, (ty + 1) * tile_size - 1, SOUTH);
+        }
+        else {
+            size_t y = ty * tile_size + (size_t) bounded_draw64(gen, tiles[t].cell_height());
+            maze.open_wall((tx + 1) * tile_size - 1, y, EAST);
+        }
+    }
+    if (show_frames) display_last_frame(maze);
 }
+
+template bool generate_maze_into<MazeGrid>(MazeGrid& maze, string algorithm, size_t startX, 
+    size_t startY, bool random_start, bool show_frames, size_t threads, size_t tile_size, uint64_t seed);
+template bool generate_maze_into<PackedMaze>(PackedMaze& maze, string algorithm, size_t startX, 
+    size_t startY, bool random_start, bool show_frames, size_t threads, size_t tile_size, uint64_t seed);
+
+// carvers are instantiated for the default engine and the standard Mersenne Twister
+#define INSTANTIATE_CARVERS(Maze, URNG) \
+    template void carve_depth_first_search<Maze, URNG>(Maze& maze, URNG& gen, size_t startX, size_t startY, \
+        bool random_start, bool show_frames); \
+    template void carve_kruskal<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_kruskal_parallel<Maze, URNG>(Maze& maze, URNG& gen, size_t threads, bool show_frames); \
+    template void carve_prim<Maze, URNG>(Maze& maze, URNG& gen, size_t startX, size_t startY, \
+        bool random_start, bool show_frames); \
+    template void carve_aldous_broder<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_wilson<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_aldous_broder_wilson<Maze, URNG>(Maze& maze, URNG& gen, double coverage, \
+        bool show_frames); \
+    template void carve_recursive_division<Maze, URNG>(Maze& maze, URNG& gen, size_t threads, bool show_frames); \
+    template void carve_eller<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_sidewinder<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_binary_tree<Maze, URNG>(Maze& maze, URNG& gen, bool show_frames); \
+    template void carve_tiled<Maze, URNG>(Maze& maze, URNG& gen, string algorithm, size_t tile_size, \
+        size_t threads, bool show_frames);
+
+INSTANTIATE_CARVERS(MazeGrid, xoshiro256)
+INSTANTIATE_CARVERS(PackedMaze, xoshiro256)
+INSTANTIATE_CARVERS(MazeGrid, std::mt19937)
+INSTANTIATE_CARVERS(PackedMaze, std::mt19937)
@@ -2,6 +2,14 @@
 #include <string>
 #include <memory>
 
+#include "maze_grid.h"
+#include "packed_maze.h"
+#include "maze_file.h"
+#include "maze_stream.h"
+#include "maze_bulk.h"
+#include "terminal_renderer.h"
+#include "random.h"
+
 using std::pair;
 using std::vector;
 using std::size_t;
@@ -9,34 +17,119 @@ using std::unique_ptr;
 using std::string;
 
 
+void display_maze(const MazeGrid& grid);
+
+void save_maze(const MazeGrid& grid, string file_path, bool binary=true);
+
+unique_ptr<MazeGrid> load_maze(string file_path, bool display=false);
+
+void display_maze(const PackedMaze& maze);
+
+void save_maze(const PackedMaze& maze, string file_path, bool binary=true);
+
+// adapters for the legacy column-major nested vector grid
 void display_maze(vector<vector<int>>& grid);
 
 void save_maze(vector<vector<int>>& grid, string file_path, bool binary=true);
 
-unique_ptr<vector<vector<int>>> load_maze(string file_path, bool display=false);
+unique_ptr<vector<vector<int>>> load_maze_nested(string file_path, bool display=false);
+
+unique_ptr<vector<vector<int>>> generate_maze_nested(size_t width, size_t height, string algorithm="aldous-broder",
+    size_t startX=0, size_t startY=0, bool random_start=true, bool show_frames=false, size_t threads=0,
+    size_t tile_size=0, uint64_t seed=random_seed());
 
 pair<size_t, size_t> random_coordinate(size_t width, size_t height);
 
 template <class URNG>
-pair<size_t, size_t> random_coordinate(size_t width, size_t height);
+pair<size_t, size_t> random_coordinate(URNG& gen, size_t width, size_t height);
 
 template <class URNG>
 pair<size_t, size_t> random_maze_coordinate(URNG& gen, size_t width, size_t height);
 
-unique_ptr<vector<vector<int>>> randomized_depth_first_search(size_t width, size_t height, 
-    size_t startX=0, size_t startY=0, bool random_start=true, bool show_frames=false);
+// generators writing into an existing MazeGrid or PackedMaze, drawing from gen
+// (xoshiro256 or std::mt19937)
+template <class Maze, class URNG>
+void carve_depth_first_search(Maze& maze, URNG& gen, size_t startX=0, size_t startY=0, 
+    bool random_start=true, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_kruskal(Maze& maze, URNG& gen, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_kruskal_parallel(Maze& maze, URNG& gen, size_t threads=0, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_prim(Maze& maze, URNG& gen, size_t startX=0, size_t startY=0, bool random_start=true, 
+    bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_aldous_broder(Maze& maze, URNG& gen, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_wilson(Maze& maze, URNG& gen, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_aldous_broder_wilson(Maze& maze, URNG& gen, double coverage=1.0/3, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_recursive_division(Maze& maze, URNG& gen, size_t threads=0, bool show_frames=false);
+
+// row by row generators, see MazeRowStream
+template <class Maze, class URNG>
+void carve_eller(Maze& maze, URNG& gen, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_sidewinder(Maze& maze, URNG& gen, bool show_frames=false);
+
+template <class Maze, class URNG>
+void carve_binary_tree(Maze& maze, URNG& gen, bool show_frames=false);
+
+// whether an algorithm name is one of the generators
+bool is_generator_algorithm(string algorithm);
+
+// tiles generated in parallel with any of the algorithms above, then stitched into one perfect maze
+template <class Maze, class URNG>
+void carve_tiled(Maze& maze, URNG& gen, string algorithm="kruskal", size_t tile_size=256, size_t threads=0, 
+    bool show_frames=false);
+
+template <class Maze>
+bool generate_maze_into(Maze& maze, string algorithm="aldous-broder", size_t startX=0, size_t startY=0, 
+    bool random_start=true, bool show_frames=false, size_t threads=0, size_t tile_size=0, 
+    uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> randomized_depth_first_search(size_t width, size_t height, 
+    size_t startX=0, size_t startY=0, bool random_start=true, bool show_frames=false, 
+    uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> kruskal(size_t width, size_t height, bool show_frames=false, uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> kruskal_parallel(size_t width, size_t height, size_t threads=0, bool show_frames=false,
+    uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> prim(size_t width, size_t height, size_t startX=0, 
+    size_t startY=0, bool random_start=true, bool show_frames=false, uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> aldous_broder(size_t width, size_t height, bool show_frames=false, 
+    uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> wilson(size_t width, size_t height, bool show_frames=false, uint64_t seed=random_seed());
+
+unique_ptr<MazeGrid> aldous_broder_wilson(size_t width, size_t height, double coverage=1.0/3, 
+    bool show_frames=false, uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> kruskal(size_t width, size_t height, bool show_frames=false);
+unique_ptr<MazeGrid> recursive_division(size_t width, size_t height, bool show_frames=false, size_t threads=0,
+    uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> prim(size_t width, size_t height, size_t startX=0, 
-    size_t startY=0, bool random_start=true, bool show_frames=false);
+unique_ptr<MazeGrid> eller(size_t width, size_t height, bool show_frames=false, uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> aldous_broder(size_t width, size_t height, bool show_frames=false);
+unique_ptr<MazeGrid> sidewinder(size_t width, size_t height, bool show_frames=false, uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> recursive_division(size_t width, size_t height, bool show_frames=false);
+unique_ptr<MazeGrid> binary_tree(size_t width, size_t height, bool show_frames=false, uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> generate_maze(size_t width, size_t height, string algorithm="aldous-broder",
-    size_t startX=0, size_t startY=0, bool random_start=true, bool show_frames=false);
+unique_ptr<MazeGrid> generate_maze(size_t width, size_t height, string algorithm="aldous-broder",
+    size_t startX=0, size_t startY=0, bool random_start=true, bool show_frames=false, size_t threads=0,
+    size_t tile_size=0, uint64_t seed=random_seed());
 
-unique_ptr<vector<vector<int>>> benchmark_maze(size_t width, size_t height, string algorithm, bool display=false, 
-    bool save=false, string file_path="maze.txt", bool save_binary=false);
\ No newline at end of file
+unique_ptr<PackedMaze> generate_packed_maze(size_t width, size_t height, string algorithm="aldous-broder",
+    size_t startX=0, size_t startY=0, bool random_start=true, size_t threads=0, size_t tile_size=0, 
+    uint64_t seed=random_seed());
\ No newline at end of file
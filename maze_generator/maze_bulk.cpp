@@ -0,0 +1,174 @@
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <chrono>
+#include "maze_bulk.h"
+#include "maze.h"
+#include "threading.h"
+
+using std::cerr;
+using namespace std::chrono;
+
+bulk_options default_bulk_options(size_t count, size_t size, string algorithm, string output) {
+    bulk_options options;
+    options.count = count;
+    options.min_width = options.max_width = size;
+    options.min_height = options.max_height = size;
+    options.algorithms.push_back(algorithm);
+    options.seed = 1;
+    options.threads = 0;
+    options.output = output;
+    options.shards = 0;
+    options.queue_depth = 0;
+    return options;
+}
+
+void bulk_maze_plan(const bulk_options& options, size_t index, size_t& width, size_t& height,
+    string& algorithm, uint64_t& seed) {
+    uint64_t stream = index;
+    xoshiro256 gen(options.seed ^ splitmix64(stream)); // independent of every other index
+    seed = gen();
+    width = options.min_width + (size_t) bounded_draw64(gen, options.max_width - options.min_width + 1);
+    height = options.min_height + (size_t) bounded_draw64(gen, options.max_height - options.min_height + 1);
+    if (options.weights.empty()) {
+        algorithm = options.algorithms[(size_t) bounded_draw64(gen, options.algorithms.size())];
+        return;
+    }
+    double total = 0;
+    for (size_t i = 0; i < options.algorithms.size(); ++i) total += options.weights[i];
+    double point = (double) (gen() >> 11) / 9007199254740992.0 * total; // 53 random bits in [0, total)
+    size_t chosen = 0;
+    while (chosen + 1 < options.algorithms.size() && point >= options.weights[chosen])
+        point -= options.weights[chosen++];
+    algorithm = options.algorithms[chosen];
+}
+
+static bool check_bulk_options(const bulk_options& options) {
+    if (options.min_width == 0 || options.min_height == 0 || options.min_width > options.max_width
+        || options.min_height > options.max_height) {
+        cerr << "ERROR: invalid maze size range!\n";
+        return false;
+    }
+    if (options.algorithms.empty()) {
+        cerr << "ERROR: no maze generation algorithm provided!\n";
+        return false;
+    }
+    for (const string& algorithm : options.algorithms)
+        if (!is_generator_algorithm(algorithm)) {
+            cerr << "ERROR: invalid maze generation algorithm provided!\n";
+            return false;
+        }
+    if (!options.weights.empty()) {
+        double total = 0;
+        for (double weight : options.weights) {
+            if (!(weight >= 0)) total = -1;
+            else if (total >= 0) total += weight;
+        }
+        if (options.weights.size() != options.algorithms.size() || !(total > 0)) {
+            cerr << "ERROR: algorithm weights must be one non-negative weight per algorithm!\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// maze in flight between a generating thread and the writer
+struct bulk_maze {
+    size_t index;
+    PackedMaze maze;
+    string algorithm;
+    uint64_t seed;
+};
+
+bool generate_bulk_mazes(const bulk_options& options, bulk_stats* stats) {
+    if (!check_bulk_options(options)) return false;
+    auto start = steady_clock::now();
+    size_t shard_count = std::max(options.shards, (size_t) 1);
+    vector<unique_ptr<std::ofstream>> files;
+    if (!options.output.empty()) {
+        for (size_t k = 0; k < shard_count; ++k) {
+            string path = options.shards > 1 ? options.output + "." + std::to_string(k) : options.output;
+            files.push_back(unique_ptr<std::ofstream>(new std::ofstream(path, std::ios::binary)));
+            if (!files.back()->is_open()) {
+                cerr << "ERROR: unable to open file!\n";
+                return false;
+            }
+        }
+    }
+
+    size_t threads = resolve_thread_count(options.threads);
+    size_t buffer_count = threads + (options.queue_depth > 0 ? options.queue_depth : 2 * threads);
+    std::mutex mutex;
+    std::condition_variable buffer_returned, maze_finished;
+    vector<unique_ptr<bulk_maze>> buffers; // free buffers
+    for (size_t i = 0; i < buffer_count; ++i) buffers.push_back(unique_ptr<bulk_maze>(new bulk_maze()));
+    std::map<size_t, unique_ptr<bulk_maze>> finished; // generated mazes waiting for their turn to be written
+    size_t next_index = 0;
+
+    // a thread takes a buffer before its index, so the lowest unwritten maze always has one
+    auto generate = [&]() {
+        while (true) {
+            unique_ptr<bulk_maze> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                buffer_returned.wait(lock, [&] { return !buffers.empty() || next_index == options.count; });
+                if (next_index == options.count) return;
+                job = std::move(buffers.back());
+                buffers.pop_back();
+                job->index = next_index++;
+            }
+            if (job->index + 1 == options.count) buffer_returned.notify_all(); // nothing left to take
+            size_t width, height;
+            bulk_maze_plan(options, job->index, width, height, job->algorithm, job->seed);
+            job->maze.resize(width, height);
+            generate_maze_into(job->maze, job->algorithm, 0, 0, true, false, 1, 0, job->seed);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished[job->index] = std::move(job);
+            }
+            maze_finished.notify_one();
+        }
+    };
+    bulk_stats totals = {0, 0, 0, 0};
+    auto write = [&]() {
+        for (size_t index = 0; index < options.count; ++index) {
+            unique_ptr<bulk_maze> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                maze_finished.wait(lock, [&] { return finished.count(index) > 0; });
+                job = std::move(finished[index]);
+                finished.erase(index);
+            }
+            if (!files.empty()) {
+                write_maze_record(*files[index % files.size()], job->maze, job->algorithm, job->seed);
+                totals.bytes += (sizeof(MazeFileHeader) + job->maze.bytes() + 7) / 8 * 8;
+            }
+            totals.mazes++;
+            totals.cells += job->maze.cells();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                buffers.push_back(std::move(job));
+            }
+            buffer_returned.notify_one();
+        }
+    };
+
+    std::thread writer(write);
+    vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) workers.push_back(std::thread(generate));
+    for (size_t t = 0; t < threads; ++t) workers[t].join();
+    writer.join();
+
+    bool written = true;
+    for (size_t k = 0; k < files.size(); ++k) {
+        files[k]->close();
+        if (files[k]->fail()) written = false;
+    }
+    if (!written) cerr << "ERROR: unable to write " << options.output << "!\n";
+    totals.seconds = duration_cast<nanoseconds>(steady_clock::now() - start).count() / 1e9;
+    if (stats) *stats = totals;
+    return written;
+}
@@ -0,0 +1,66 @@
+#ifndef MAZE_BULK_H
+#define MAZE_BULK_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint64_t;
+
+/**
+ * Job of many mazes generated at once, for example levels or training data
+ * Every maze has its size, algorithm and seed drawn from the base seed and its
+ * index alone, so a job gives the same mazes whatever the number of threads,
+ * and any one maze can be generated again from the seed in its header.
+ */
+struct bulk_options {
+    size_t count; // number of mazes
+    size_t min_width; // widths and heights are drawn uniformly from these ranges, in cells
+    size_t max_width;
+    size_t min_height;
+    size_t max_height;
+    vector<string> algorithms; // algorithm mix
+    vector<double> weights; // relative weight of each algorithm, equal if empty
+    uint64_t seed; // base seed of the job
+    size_t threads; // generating threads, 0 uses one per hardware thread
+    string output; // archive path, or prefix of the shards, empty writes nothing
+    size_t shards; // 0 or 1 writes one archive, more writes output.0 to output.<shards-1>
+    size_t queue_depth; // finished mazes that may wait for the writer
+};
+
+struct bulk_stats {
+    size_t mazes;
+    size_t cells;
+    size_t bytes; // bytes written
+    double seconds;
+};
+
+/**
+ * Options for count square mazes of one size and algorithm, written to one archive
+ */
+bulk_options default_bulk_options(size_t count, size_t size, string algorithm="kruskal", string output="");
+
+/**
+ * Size, algorithm and seed of maze index of a job
+ */
+void bulk_maze_plan(const bulk_options& options, size_t index, size_t& width, size_t& height,
+    string& algorithm, uint64_t& seed);
+
+/**
+ * Generate the mazes of a job on a pool of threads
+ * Each thread takes a buffer from a fixed pool, generates the next maze into
+ * it and hands it to a writer thread, which appends the mazes to the archive
+ * or their shard in index order and returns the buffers. Buffers keep their
+ * storage between mazes, and generation waits for the writer when all of them
+ * are queued.
+ *
+ * @param stats if given, filled with the number of mazes, cells and bytes and the time taken
+ * @return false if the options are invalid or an output file cannot be opened
+ */
+bool generate_bulk_mazes(const bulk_options& options, bulk_stats* stats=nullptr);
+
+#endif
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "maze_file.h"
+
+using std::cerr;
+
+static_assert(sizeof(MazeFileHeader) == 64, "maze file header must stay 64 bytes");
+
+static const char maze_file_magic[4] = {'M', 'A', 'Z', 'E'};
+
+void write_maze_header(std::ostream& out, size_t width, size_t height, string algorithm, uint64_t seed) {
+    MazeFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, maze_file_magic, sizeof(header.magic));
+    header.version = maze_file_version;
+    header.width = width;
+    header.height = height;
+    header.seed = seed;
+    header.encoding = PACKED_EAST_SOUTH;
+    header.header_size = sizeof(header);
+    algorithm.copy(header.algorithm, sizeof(header.algorithm) - 1);
+    out.write((const char*) &header, sizeof(header));
+}
+
+void save_maze_file(const PackedMaze& maze, string file_path, string algorithm, uint64_t seed) {
+    std::ofstream outfile(file_path, std::ios::binary);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        exit(1);
+    }
+    write_maze_header(outfile, maze.cell_width(), maze.cell_height(), algorithm, seed);
+    outfile.write((const char*) maze.data(), maze.bytes());
+}
+
+void save_maze_file(const MazeGrid& grid, string file_path, string algorithm, uint64_t seed) {
+    save_maze_file(PackedMaze(grid), file_path, algorithm, seed);
+}
+
+// bytes from the start of a record to the next one in an archive
+static uint64_t record_size(const MazeFileHeader& header) {
+    return (header.header_size + (header.width * header.height + 3) / 4 + 7) / 8 * 8;
+}
+
+void write_maze_record(std::ostream& out, const PackedMaze& maze, string algorithm, uint64_t seed) {
+    static const char padding[8] = {0};
+    write_maze_header(out, maze.cell_width(), maze.cell_height(), algorithm, seed);
+    out.write((const char*) maze.data(), maze.bytes());
+    out.write(padding, (8 - (sizeof(MazeFileHeader) + maze.bytes()) % 8) % 8);
+}
+
+// check a header read from a file of the given size
+static bool check_maze_header(const MazeFileHeader& header, uint64_t file_size, string file_path) {
+    if (std::memcmp(header.magic, maze_file_magic, sizeof(header.magic)) != 0) return false;
+    if (header.version != maze_file_version || header.encoding != PACKED_EAST_SOUTH
+        || header.header_size < sizeof(header)) {
+        cerr << "ERROR: " << file_path << " has an unsupported maze file version or encoding!\n";
+        return false;
+    }
+    // sizes come from disk, so reject any that would wrap before doing arithmetic on them
+    const uint64_t max_size = (uint64_t) -1;
+    if (header.width != 0 && header.height > (max_size - 3) / header.width) {
+        cerr << "ERROR: " << file_path << " has invalid dimensions!\n";
+        return false;
+    }
+    uint64_t payload = (header.width * header.height + 3) / 4;
+    if (payload > max_size - 7 - header.header_size || file_size < header.header_size + payload) {
+        cerr << "ERROR: " << file_path << " is truncated!\n";
+        return false;
+    }
+    return true;
+}
+
+bool is_maze_file(string file_path) {
+    std::ifstream infile(file_path, std::ios::binary);
+    char magic[sizeof(maze_file_magic)];
+    return infile.read(magic, sizeof(magic)) && std::memcmp(magic, maze_file_magic, sizeof(magic)) == 0;
+}
+
+bool read_maze_header(string file_path, MazeFileHeader& header) {
+    std::ifstream infile(file_path, std::ios::binary | std::ios::ate);
+    if (!infile.is_open()) return false;
+    uint64_t file_size = (uint64_t) infile.tellg();
+    infile.seekg(0);
+    if (!infile.read((char*) &header, sizeof(header))) return false;
+    return check_maze_header(header, file_size, file_path);
+}
+
+/**
+ * Map a whole file privately and writable, so mazes can be changed in memory
+ * without touching the file
+ *
+ * @param size set to the file size
+ * @return empty if the file cannot be mapped or is too short for a header
+ */
+static std::shared_ptr<void> map_private(const string& file_path, size_t& size) {
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "ERROR: unable to open file!\n";
+        return std::shared_ptr<void>();
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(MazeFileHeader)) {
+        cerr << "ERROR: " << file_path << " is not a binary maze file!\n";
+        close(fd);
+        return std::shared_ptr<void>();
+    }
+    size = (size_t) info.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid
+    if (mapping == MAP_FAILED) {
+        cerr << "ERROR: unable to map " << file_path << "!\n";
+        return std::shared_ptr<void>();
+    }
+    size_t mapped_size = size;
+    return std::shared_ptr<void>(mapping, [mapped_size](void* address) { munmap(address, mapped_size); });
+}
+
+unique_ptr<PackedMaze> map_maze_file(string file_path, MazeFileHeader* header) {
+    size_t size = 0;
+    std::shared_ptr<void> owner = map_private(file_path, size);
+    if (!owner) return unique_ptr<PackedMaze>();
+    void* mapping = owner.get();
+    const MazeFileHeader& mapped = *(const MazeFileHeader*) mapping;
+    if (!check_maze_header(mapped, size, file_path)) {
+        if (std::memcmp(mapped.magic, maze_file_magic, sizeof(mapped.magic)) != 0)
+            cerr << "ERROR: " << file_path << " is not a binary maze file!\n";
+        return unique_ptr<PackedMaze>();
+    }
+    if (header) *header = mapped;
+    uint8_t* payload = (uint8_t*) mapping + mapped.header_size;
+    return unique_ptr<PackedMaze>{new PackedMaze(mapped.width, mapped.height, payload, owner)};
+}
+
+vector<unique_ptr<PackedMaze>> map_maze_archive(string file_path, vector<MazeFileHeader>* headers) {
+    vector<unique_ptr<PackedMaze>> mazes;
+    if (headers) headers->clear();
+    size_t size = 0;
+    std::shared_ptr<void> owner = map_private(file_path, size);
+    if (!owner) return mazes;
+    uint8_t* mapping = (uint8_t*) owner.get();
+    for (uint64_t offset = 0; offset < size; ) {
+        MazeFileHeader header;
+        if (size - offset < sizeof(header)) {
+            cerr << "ERROR: " << file_path << " is truncated!\n";
+            mazes.clear();
+            break;
+        }
+        std::memcpy(&header, mapping + offset, sizeof(header));
+        if (!check_maze_header(header, size - offset, file_path)) {
+            if (std::memcmp(header.magic, maze_file_magic, sizeof(header.magic)) != 0)
+                cerr << "ERROR: " << file_path << " has a record that is not a maze at byte " << offset << "!\n";
+            mazes.clear();
+            break;
+        }
+        uint8_t* payload = mapping + offset + header.header_size;
+        mazes.push_back(unique_ptr<PackedMaze>{new PackedMaze(header.width, header.height, payload, owner)});
+        if (headers) headers->push_back(header);
+        offset += record_size(header);
+    }
+    if (mazes.empty() && headers) headers->clear();
+    return mazes;
+}
@@ -0,0 +1,92 @@
+#ifndef MAZE_FILE_H
+#define MAZE_FILE_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+#include "maze_grid.h"
+#include "packed_maze.h"
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+using std::uint32_t;
+using std::uint64_t;
+
+/**
+ * Binary maze file format
+ * A 64 byte header in host byte order followed by the cell payload. With the
+ * packed encoding the payload is exactly the bits of a PackedMaze, so a mapped
+ * file is used in place.
+ *
+ * An archive is a sequence of maze files, each padded to a multiple of 8
+ * bytes so every header stays aligned. A single maze file is an archive of one.
+ */
+enum MazeEncoding { PACKED_EAST_SOUTH = 1 }; // 2 bits per cell as in PackedMaze
+
+const uint32_t maze_file_version = 1;
+
+struct MazeFileHeader {
+    char magic[4]; // "MAZE"
+    uint32_t version;
+    uint64_t width; // cells in a row
+    uint64_t height; // rows of cells
+    uint64_t seed; // seed the maze was generated from, 0 if unknown
+    uint32_t encoding; // MazeEncoding of the payload
+    uint32_t header_size; // payload offset, so later versions can extend the header
+    char algorithm[24]; // generator name, NUL padded
+};
+
+/**
+ * Write the header of a binary maze file, the payload follows it
+ */
+void write_maze_header(std::ostream& out, size_t width, size_t height, string algorithm="", uint64_t seed=0);
+
+/**
+ * Save a maze in the binary format
+ *
+ * @param algorithm name of the generator, truncated to 23 characters
+ */
+void save_maze_file(const PackedMaze& maze, string file_path, string algorithm="", uint64_t seed=0);
+
+void save_maze_file(const MazeGrid& grid, string file_path, string algorithm="", uint64_t seed=0);
+
+/**
+ * Append a maze to an archive stream as a header, its payload and padding
+ */
+void write_maze_record(std::ostream& out, const PackedMaze& maze, string algorithm="", uint64_t seed=0);
+
+/**
+ * Whether a file starts with the binary maze file magic
+ */
+bool is_maze_file(string file_path);
+
+/**
+ * Read and check the header of a binary maze file
+ *
+ * @return whether the file is a binary maze file this version can read
+ */
+bool read_maze_header(string file_path, MazeFileHeader& header);
+
+/**
+ * Map a binary maze file into memory and view its payload without copying
+ * The mapping is private, so changes to the maze are not written to the file.
+ *
+ * @param header if given, filled with the file header
+ * @return empty if the file cannot be opened or is not a binary maze file
+ */
+unique_ptr<PackedMaze> map_maze_file(string file_path, MazeFileHeader* header=nullptr);
+
+/**
+ * Map an archive into memory and view every maze in it without copying
+ * The mazes share one private mapping, released with the last of them.
+ *
+ * @param headers if given, filled with the header of every maze
+ * @return empty if the file cannot be opened or any record is malformed
+ */
+vector<unique_ptr<PackedMaze>> map_maze_archive(string file_path, vector<MazeFileHeader>* headers=nullptr);
+
+#endif
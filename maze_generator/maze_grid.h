@@ -0,0 +1,131 @@
+#ifndef MAZE_GRID_H
+#define MAZE_GRID_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+using std::vector;
+using std::size_t;
+using std::ptrdiff_t;
+using std::uint8_t;
+using std::unique_ptr;
+
+/**
+ * Directions between neighboring cells, in the order used for neighbor offsets
+ */
+enum Direction { WEST = 0, NORTH = 1, EAST = 2, SOUTH = 3 };
+
+/**
+ * Maze grid stored row-major in one contiguous block of 1 byte cells
+ * The grid is (2*width+1)x(2*height+1) slots, where slots with odd
+ * coordinates are maze cells and the slots between them are walls
+ *
+ * Slot values: 0 = path, 1 = wall, 2-5 = path finder markers
+ */
+class MazeGrid {
+    private:
+        size_t grid_width;
+        size_t grid_height;
+        size_t row_stride; // slots between the starts of two rows, >= grid_width
+        ptrdiff_t offsets[4]; // flat index offsets to the neighboring slot in each direction
+        vector<uint8_t> slots;
+
+        void set_offsets() {
+            offsets[WEST] = -1;
+            offsets[NORTH] = -(ptrdiff_t) row_stride;
+            offsets[EAST] = 1;
+            offsets[SOUTH] = (ptrdiff_t) row_stride;
+        }
+    public:
+        MazeGrid() : grid_width(0), grid_height(0), row_stride(0) {
+            set_offsets();
+        }
+        /**
+         * @param width number of slots in a row
+         * @param height number of rows
+         * @param fill initial value of every slot
+         * @param stride row stride, defaults to width when smaller than it
+         */
+        MazeGrid(size_t width, size_t height, uint8_t fill=1, size_t stride=0)
+            : grid_width(width), grid_height(height), row_stride(stride < width ? width : stride),
+            slots(row_stride * height, fill) {
+            set_offsets();
+        }
+        /**
+         * Convert from the legacy column-major nested vector layout (grid[x][y])
+         */
+        explicit MazeGrid(const vector<vector<int>>& nested)
+            : grid_width(nested.size()), grid_height(nested.empty() ? 0 : nested[0].size()),
+            row_stride(grid_width), slots(grid_width * grid_height, 1) {
+            set_offsets();
+            for (size_t i = 0; i < grid_width; ++i)
+                for (size_t j = 0; j < grid_height && j < nested[i].size(); ++j)
+                    slots[j * row_stride + i] = (uint8_t) nested[i][j];
+        }
+
+        size_t width() const { return grid_width; }
+        size_t height() const { return grid_height; }
+        size_t stride() const { return row_stride; }
+        // number of maze cells along each axis
+        size_t cell_width() const { return grid_width > 0 ? (grid_width - 1) / 2 : 0; }
+        size_t cell_height() const { return grid_height > 0 ? (grid_height - 1) / 2 : 0; }
+        bool empty() const { return grid_width == 0 || grid_height == 0; }
+
+        size_t index(size_t x, size_t y) const { return y * row_stride + x; }
+        /**
+         * Flat index of the slot next to the given one
+         */
+        size_t neighbor(size_t index, Direction dir) const { return index + offsets[dir]; }
+        ptrdiff_t offset(Direction dir) const { return offsets[dir]; }
+
+        uint8_t& operator()(size_t x, size_t y) { return slots[y * row_stride + x]; }
+        uint8_t operator()(size_t x, size_t y) const { return slots[y * row_stride + x]; }
+        uint8_t& operator[](size_t index) { return slots[index]; }
+        uint8_t operator[](size_t index) const { return slots[index]; }
+
+        uint8_t* data() { return slots.data(); }
+        const uint8_t* data() const { return slots.data(); }
+        uint8_t* row(size_t y) { return slots.data() + y * row_stride; }
+        const uint8_t* row(size_t y) const { return slots.data() + y * row_stride; }
+
+        /**
+         * Wall operations in cell coordinates, shared with PackedMaze so that
+         * generators and solvers can be written once for both representations
+         */
+        size_t wall_index(size_t x, size_t y, Direction dir) const {
+            return index(2*x+1, 2*y+1) + offsets[dir];
+        }
+        bool has_wall(size_t x, size_t y, Direction dir) const { return slots[wall_index(x, y, dir)] == 1; }
+        void open_wall(size_t x, size_t y, Direction dir) { slots[wall_index(x, y, dir)] = 0; }
+        void close_wall(size_t x, size_t y, Direction dir) { slots[wall_index(x, y, dir)] = 1; }
+
+        void fill(uint8_t value) {
+            std::fill(slots.begin(), slots.end(), value);
+        }
+
+        /**
+         * Convert to the legacy column-major nested vector layout (grid[x][y])
+         */
+        unique_ptr<vector<vector<int>>> to_nested() const {
+            vector<vector<int>>* nested = new vector<vector<int>>(grid_width, vector<int>(grid_height));
+            for (size_t j = 0; j < grid_height; ++j) {
+                const uint8_t* slot = row(j);
+                for (size_t i = 0; i < grid_width; ++i)
+                    (*nested)[i][j] = slot[i];
+            }
+            return unique_ptr<vector<vector<int>>>{nested};
+        }
+        /**
+         * Copy slots back into an existing legacy nested vector of the same dimensions
+         */
+        void copy_to(vector<vector<int>>& nested) const {
+            for (size_t i = 0; i < grid_width && i < nested.size(); ++i)
+                for (size_t j = 0; j < grid_height && j < nested[i].size(); ++j)
+                    nested[i][j] = slots[j * row_stride + i];
+        }
+};
+
+#endif
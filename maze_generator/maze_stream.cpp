@@ -0,0 +1,172 @@
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include "maze_stream.h"
+#include "maze_file.h"
+
+using std::cerr;
+
+MazeRowStream::MazeRowStream(size_t width, size_t height, Algorithm algorithm, uint64_t seed)
+    : width(width), height(height), next_y(0), algorithm(algorithm), gen(seed), coins(gen) {
+    if (algorithm == ELLER) {
+        lefts.resize(width);
+        rights.resize(width);
+        for (size_t x = 0; x < width; ++x) lefts[x] = rights[x] = (uint32_t) x; // every cell starts in its own set
+    }
+}
+
+bool MazeRowStream::is_row_algorithm(string algorithm) {
+    return algorithm == "eller" || algorithm == "sidewinder" || algorithm == "binary-tree";
+}
+
+unique_ptr<MazeRowStream> MazeRowStream::create(size_t width, size_t height, string algorithm,
+    uint64_t seed) {
+    if (!is_row_algorithm(algorithm)) {
+        cerr << "ERROR: invalid maze generation algorithm provided!\n";
+        return unique_ptr<MazeRowStream>();
+    }
+    if (width == 0 || height == 0) return unique_ptr<MazeRowStream>();
+    if (width >= (size_t) std::numeric_limits<uint32_t>::max()) {
+        cerr << "ERROR: maze rows are too wide for 32-bit set labels!\n";
+        return unique_ptr<MazeRowStream>();
+    }
+    Algorithm chosen = algorithm == "eller" ? ELLER : algorithm == "sidewinder" ? SIDEWINDER : BINARY_TREE;
+    return unique_ptr<MazeRowStream>{new MazeRowStream(width, height, chosen, seed)};
+}
+
+bool MazeRowStream::next_row(uint8_t* east_walls, uint8_t* south_walls) {
+    if (done()) return false;
+    bool last = next_y + 1 == height;
+    if (algorithm == ELLER) eller_row(last, east_walls, south_walls);
+    else if (algorithm == SIDEWINDER) sidewinder_row(last, east_walls, south_walls);
+    else binary_tree_row(last, east_walls, south_walls);
+    next_y++;
+    return true;
+}
+
+/**
+ * One row of Eller's algorithm
+ * Neighboring cells in different sets are joined at random, then cells leave
+ * their set at random by closing their south wall, as long as they are not the
+ * last cell of it. On the last row every pair of different sets is joined and
+ * nothing opens south.
+ *
+ * Sets never cross each other in a row, so each set is kept as a circular
+ * list of its cells in increasing order: two neighbors are in the same set
+ * exactly when they are next to each other in the list, and joining two sets
+ * or removing a cell is a constant time splice.
+ */
+void MazeRowStream::eller_row(bool last, uint8_t* east_walls, uint8_t* south_walls) {
+    // the splices are written branch free since the coin flips are not predictable,
+    // a splice that is not taken writes every link back unchanged
+    for (size_t x = 0; x + 1 < width; ++x) {
+        uint32_t next = (uint32_t) x + 1;
+        bool join = (rights[x] != next) & (coin() | last);
+        uint32_t right = rights[x], left = lefts[next]; // splice the list of next in after x
+        rights[left] = join ? right : rights[left];
+        lefts[right] = join ? left : lefts[right];
+        rights[x] = join ? next : rights[x];
+        lefts[next] = join ? (uint32_t) x : lefts[next];
+        east_walls[x] = !join;
+    }
+    east_walls[width - 1] = 1;
+    for (size_t x = 0; x < width; ++x) {
+        bool leave = last | ((rights[x] != x) & coin()); // the cell below starts a new set
+        uint32_t right = rights[x], left = lefts[x];
+        rights[left] = leave ? right : rights[left];
+        lefts[right] = leave ? left : lefts[right];
+        lefts[x] = leave ? (uint32_t) x : lefts[x];
+        rights[x] = leave ? (uint32_t) x : rights[x];
+        south_walls[x] = leave;
+    }
+}
+
+/**
+ * One row of the sidewinder algorithm, carving south instead of north so the
+ * row is final when it is produced
+ * Runs of cells are joined east until a coin flip or the border closes the
+ * run, which then opens south from one of its cells. The last row is one
+ * open corridor.
+ */
+void MazeRowStream::sidewinder_row(bool last, uint8_t* east_walls, uint8_t* south_walls) {
+    for (size_t x = 0; x < width; ++x) {
+        east_walls[x] = x + 1 == width ? 1 : 0;
+        south_walls[x] = 1;
+    }
+    if (last) return;
+    size_t run_start = 0;
+    for (size_t x = 0; x < width; ++x) {
+        if (x + 1 < width && coin()) continue;
+        east_walls[x] = 1;
+        uint32_t run = (uint32_t) (x - run_start + 1);
+        south_walls[run_start + bounded_draw(gen, run)] = 0;
+        run_start = x + 1;
+    }
+}
+
+/**
+ * One row of the binary tree algorithm, every cell opens east or south
+ * Cells on the east border can only open south and cells on the last row
+ * only east.
+ */
+void MazeRowStream::binary_tree_row(bool last, uint8_t* east_walls, uint8_t* south_walls) {
+    for (size_t x = 0; x < width; ++x) { // branch free, the coin flips are not predictable
+        uint8_t east = (uint8_t) ((coin() | last) & (x + 1 < width));
+        east_walls[x] = (uint8_t) (east ^ 1);
+        south_walls[x] = (uint8_t) (east | last);
+    }
+}
+
+bool stream_maze(size_t width, size_t height, string file_path, string algorithm, string format,
+    uint64_t seed) {
+    if (format != "packed" && format != "binary" && format != "display") {
+        cerr << "ERROR: Invalid maze file format!\n";
+        return false;
+    }
+    unique_ptr<MazeRowStream> stream = MazeRowStream::create(width, height, algorithm, seed);
+    if (!stream) return false;
+    std::ofstream outfile(file_path, std::ios::binary);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        exit(1);
+    }
+    vector<uint8_t> east_walls(width), south_walls(width);
+
+    if (format == "packed") {
+        write_maze_header(outfile, width, height, algorithm, seed);
+        vector<uint8_t> bytes;
+        bytes.reserve(width / 4 + 1);
+        uint8_t partial = 0; // cells of a byte that is split across rows
+        size_t cell = 0;
+        while (stream->next_row(east_walls.data(), south_walls.data())) {
+            for (size_t x = 0; x < width; ++x, ++cell) {
+                partial |= (uint8_t) ((east_walls[x] | south_walls[x] << 1) << ((cell & 3) * 2));
+                if ((cell & 3) == 3) {
+                    bytes.push_back(partial);
+                    partial = 0;
+                }
+            }
+            outfile.write((const char*) bytes.data(), bytes.size());
+            bytes.clear();
+        }
+        if (cell & 3) outfile.put((char) partial);
+        return true;
+    }
+
+    // legacy text, each row of cells is a line of cells and east walls then a line of south walls
+    string wall = "██", path = "  ";
+    if (format == "binary") wall = "1", path = "0";
+    string line, border;
+    for (size_t i = 0; i < 2 * width + 1; ++i) border += wall;
+    border += "\n";
+    outfile << border;
+    while (stream->next_row(east_walls.data(), south_walls.data())) {
+        line.assign(wall);
+        for (size_t x = 0; x < width; ++x) line.append(path).append(east_walls[x] ? wall : path);
+        line.append("\n").append(wall);
+        for (size_t x = 0; x < width; ++x) line.append(south_walls[x] ? wall : path).append(wall);
+        line.append("\n");
+        outfile.write(line.data(), line.size());
+    }
+    return true;
+}
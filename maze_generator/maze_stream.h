@@ -0,0 +1,90 @@
+#ifndef MAZE_STREAM_H
+#define MAZE_STREAM_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "random.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+using std::unique_ptr;
+
+/**
+ * Maze generated one row of cells at a time in O(width) memory
+ * Each row is final once it is produced, so it can be written out and
+ * forgotten. The walls of a row are given as the wall east of every cell and
+ * the wall south of every cell, with the border always closed.
+ *
+ * Algorithms:
+ *     eller        perfect maze, keeps only the sets of the cells of one row
+ *     sidewinder   runs of open east walls, each with one opening south
+ *     binary-tree  every cell opens east or south, biased towards the south east corner
+ */
+class MazeRowStream {
+    private:
+        enum Algorithm { ELLER, SIDEWINDER, BINARY_TREE };
+
+        size_t width;
+        size_t height;
+        size_t next_y;
+        Algorithm algorithm;
+        xoshiro256 gen;
+        random_bits<xoshiro256> coins;
+
+        // Eller's state, every set of cells in the row is a circular list in increasing order
+        vector<uint32_t> lefts;
+        vector<uint32_t> rights;
+
+        MazeRowStream(size_t width, size_t height, Algorithm algorithm, uint64_t seed);
+        bool coin() { return coins.coin(); }
+        void eller_row(bool last, uint8_t* east_walls, uint8_t* south_walls);
+        void sidewinder_row(bool last, uint8_t* east_walls, uint8_t* south_walls);
+        void binary_tree_row(bool last, uint8_t* east_walls, uint8_t* south_walls);
+    public:
+        /**
+         * Start a maze
+         *
+         * @param algorithm eller, sidewinder or binary-tree
+         * @param seed seed of the generator, the same seed gives the same rows
+         * @return empty if the algorithm is invalid or the maze is empty
+         */
+        static unique_ptr<MazeRowStream> create(size_t width, size_t height, string algorithm="eller",
+            uint64_t seed=random_seed());
+        // whether an algorithm can be streamed
+        static bool is_row_algorithm(string algorithm);
+
+        size_t cell_width() const { return width; }
+        size_t cell_height() const { return height; }
+        // row the next call to next_row produces
+        size_t row() const { return next_y; }
+        bool done() const { return next_y == height; }
+
+        /**
+         * Generate the next row of cells
+         *
+         * @param east_walls width bytes, set to 1 where a cell has a wall on its east side
+         * @param south_walls width bytes, set to 1 where a cell has a wall on its south side
+         * @return false once every row has been generated
+         */
+        bool next_row(uint8_t* east_walls, uint8_t* south_walls);
+};
+
+/**
+ * Generate a maze row by row straight into a file, without holding the maze
+ *
+ * @param algorithm eller, sidewinder or binary-tree
+ * @param format packed for the binary maze file, binary for 0s and 1s, display for blocks
+ * @param seed seed of the generator, recorded in the header of packed files
+ * @return false if the algorithm or format is invalid
+ */
+bool stream_maze(size_t width, size_t height, string file_path, string algorithm="eller",
+    string format="packed", uint64_t seed=random_seed());
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef MAZE_WALK_H
+#define MAZE_WALK_H
+
+#include <cstddef>
+
+#include "maze_grid.h"
+
+using std::size_t;
+using std::ptrdiff_t;
+
+/**
+ * Moving between the cells of a MazeGrid or PackedMaze
+ * Coordinates are wrt the number of cells and flat cell indices are
+ * y * width + x. The outer border is always closed.
+ */
+
+// step between the flat index of a cell and the one of its neighbor in a direction
+inline ptrdiff_t neighbor_offset(Direction dir, size_t width) {
+    switch (dir) {
+        case WEST: return -1;
+        case NORTH: return -(ptrdiff_t) width;
+        case EAST: return 1;
+        default: return (ptrdiff_t) width;
+    }
+}
+
+// whether a cell has a neighbor in a direction with no wall between them
+template <class Maze>
+inline bool has_opening(const Maze& maze, size_t x, size_t y, Direction dir) {
+    return !((dir == WEST && x == 0) || (dir == NORTH && y == 0)
+        || (dir == EAST && x + 1 == maze.cell_width()) || (dir == SOUTH && y + 1 == maze.cell_height())
+        || maze.has_wall(x, y, dir));
+}
+
+template <class Maze>
+inline bool has_opening(const Maze& maze, size_t cell, Direction dir) {
+    size_t width = maze.cell_width();
+    return has_opening(maze, cell % width, cell / width, dir);
+}
+
+/**
+ * Follow a corridor one cell on
+ * A cell with exactly two openings is part of a corridor, which is left
+ * through the opening it was not entered by. Junctions and dead ends stop
+ * the walk.
+ *
+ * @param dir direction of the step into the cell, set to the direction of the step out
+ * @return the next cell along the corridor, or the cell itself if the corridor stops there
+ */
+template <class Maze>
+size_t corridor_step(const Maze& maze, size_t cell, Direction& dir) {
+    size_t width = maze.cell_width(), x = cell % width, y = cell / width;
+    int exit = -1, openings = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (!has_opening(maze, x, y, (Direction) i)) continue;
+        openings++;
+        if (i != (dir + 2) % 4) exit = i;
+    }
+    if (openings != 2) return cell;
+    dir = (Direction) exit;
+    return cell + neighbor_offset(dir, width);
+}
+
+#endif
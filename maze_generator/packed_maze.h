@@ -0,0 +1,192 @@
+#ifndef PACKED_MAZE_H
+#define PACKED_MAZE_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "maze_grid.h"
+
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+
+/**
+ * Maze stored as 2 bits per cell: bit 0 is the wall on the east side of the
+ * cell and bit 1 is the wall on its south side. West and north walls are read
+ * from the neighboring cell and the outer border is always a wall, so a
+ * 10^10 cell maze takes about 2.5 GB.
+ *
+ * Cells are packed row-major, 4 to a byte. Concurrent writes to cells that
+ * share a byte are not safe.
+ *
+ * The bits are either owned or a view of external memory such as a mapped
+ * maze file, kept alive by a shared owner. Copies always own their bits.
+ */
+class PackedMaze {
+    private:
+        size_t maze_width;
+        size_t maze_height;
+        vector<uint8_t> owned; // empty when viewing external memory
+        uint8_t* bits;
+        size_t bit_bytes;
+        std::shared_ptr<void> external; // keeps external bits alive
+
+        static const uint8_t EAST_BIT = 1;
+        static const uint8_t SOUTH_BIT = 2;
+
+        uint8_t get(size_t cell) const {
+            return (bits[cell >> 2] >> ((cell & 3) * 2)) & 3;
+        }
+        void set(size_t cell, uint8_t bit) {
+            bits[cell >> 2] |= (uint8_t) (bit << ((cell & 3) * 2));
+        }
+        void clear(size_t cell, uint8_t bit) {
+            bits[cell >> 2] &= (uint8_t) ~(bit << ((cell & 3) * 2));
+        }
+    public:
+        PackedMaze() : maze_width(0), maze_height(0), bits(nullptr), bit_bytes(0) {}
+        /**
+         * @param width number of cells in a row
+         * @param height number of rows of cells
+         * @param walls if true, starts with every wall closed, otherwise only the border
+         */
+        PackedMaze(size_t width, size_t height, bool walls=true)
+            : maze_width(width), maze_height(height), owned((width * height + 3) / 4, walls ? 0xFF : 0),
+            bits(owned.data()), bit_bytes(owned.size()) {}
+        /**
+         * View bits held elsewhere without copying them
+         *
+         * @param data (width*height+3)/4 bytes of packed cells
+         * @param owner released when the last maze viewing the bits is destroyed
+         */
+        PackedMaze(size_t width, size_t height, uint8_t* data, std::shared_ptr<void> owner)
+            : maze_width(width), maze_height(height), bits(data), bit_bytes((width * height + 3) / 4),
+            external(owner) {}
+        /**
+         * Pack the walls of a grid, reading the east and south wall of every cell
+         */
+        explicit PackedMaze(const MazeGrid& grid) : PackedMaze(grid.cell_width(), grid.cell_height(), false) {
+            for (size_t y = 0; y < maze_height; ++y)
+                for (size_t x = 0; x < maze_width; ++x) {
+                    if (x + 1 < maze_width && grid.has_wall(x, y, EAST)) close_wall(x, y, EAST);
+                    if (y + 1 < maze_height && grid.has_wall(x, y, SOUTH)) close_wall(x, y, SOUTH);
+                }
+        }
+        PackedMaze(const PackedMaze& other)
+            : maze_width(other.maze_width), maze_height(other.maze_height),
+            owned(other.bits, other.bits + other.bit_bytes), bits(owned.data()), bit_bytes(owned.size()) {}
+        PackedMaze(PackedMaze&& other)
+            : maze_width(other.maze_width), maze_height(other.maze_height), owned(std::move(other.owned)),
+            bits(other.bits), bit_bytes(other.bit_bytes), external(std::move(other.external)) {
+            other.maze_width = other.maze_height = other.bit_bytes = 0;
+            other.bits = nullptr;
+        }
+        PackedMaze& operator=(PackedMaze other) {
+            std::swap(maze_width, other.maze_width);
+            std::swap(maze_height, other.maze_height);
+            owned.swap(other.owned);
+            std::swap(bits, other.bits);
+            std::swap(bit_bytes, other.bit_bytes);
+            external.swap(other.external);
+            return *this;
+        }
+
+        size_t cell_width() const { return maze_width; }
+        size_t cell_height() const { return maze_height; }
+        size_t cells() const { return maze_width * maze_height; }
+        bool empty() const { return maze_width == 0 || maze_height == 0; }
+        // bytes used by the wall bits
+        size_t bytes() const { return bit_bytes; }
+        // whether the bits are a view of external memory
+        bool is_view() const { return external != nullptr; }
+
+        uint8_t* data() { return bits; }
+        const uint8_t* data() const { return bits; }
+
+        /**
+         * Change the size of the maze, reusing its storage when it is large enough
+         * A view is turned into an owned maze.
+         *
+         * @param walls if true, starts with every wall closed, otherwise only the border
+         */
+        void resize(size_t width, size_t height, bool walls=true) {
+            owned.assign((width * height + 3) / 4, walls ? 0xFF : 0);
+            external.reset();
+            maze_width = width;
+            maze_height = height;
+            bits = owned.data();
+            bit_bytes = owned.size();
+        }
+        /**
+         * Close every wall, or open every wall except the border
+         */
+        void reset(bool walls) {
+            std::fill(bits, bits + bit_bytes, walls ? 0xFF : 0);
+        }
+
+        bool has_wall(size_t x, size_t y, Direction dir) const {
+            switch (dir) {
+                case WEST: return x == 0 || (get(y * maze_width + x - 1) & EAST_BIT);
+                case NORTH: return y == 0 || (get((y - 1) * maze_width + x) & SOUTH_BIT);
+                case EAST: return x + 1 >= maze_width || (get(y * maze_width + x) & EAST_BIT);
+                default: return y + 1 >= maze_height || (get(y * maze_width + x) & SOUTH_BIT);
+            }
+        }
+        void open_wall(size_t x, size_t y, Direction dir) {
+            switch (dir) {
+                case WEST: clear(y * maze_width + x - 1, EAST_BIT); break;
+                case NORTH: clear((y - 1) * maze_width + x, SOUTH_BIT); break;
+                case EAST: clear(y * maze_width + x, EAST_BIT); break;
+                default: clear(y * maze_width + x, SOUTH_BIT); break;
+            }
+        }
+        void close_wall(size_t x, size_t y, Direction dir) {
+            switch (dir) {
+                case WEST: set(y * maze_width + x - 1, EAST_BIT); break;
+                case NORTH: set((y - 1) * maze_width + x, SOUTH_BIT); break;
+                case EAST: set(y * maze_width + x, EAST_BIT); break;
+                default: set(y * maze_width + x, SOUTH_BIT); break;
+            }
+        }
+
+        /**
+         * Write one row of the equivalent (2w+1)x(2h+1) legacy grid
+         *
+         * @param j row of the legacy grid
+         * @param out buffer of at least 2*width+1 slots
+         */
+        void expand_row(size_t j, uint8_t* out) const {
+            size_t grid_width = 2 * maze_width + 1;
+            if (j == 0 || j >= 2 * maze_height) {
+                std::fill(out, out + grid_width, 1);
+                return;
+            }
+            size_t y = (j - 1) / 2;
+            out[0] = 1;
+            if (j % 2 == 1) { // cells and the walls east of them
+                for (size_t x = 0; x < maze_width; ++x) {
+                    out[2*x+1] = 0;
+                    out[2*x+2] = has_wall(x, y, EAST) ? 1 : 0;
+                }
+            }
+            else { // walls south of the cells and the corners between them
+                for (size_t x = 0; x < maze_width; ++x) {
+                    out[2*x+1] = has_wall(x, y, SOUTH) ? 1 : 0;
+                    out[2*x+2] = 1;
+                }
+            }
+        }
+        /**
+         * Expand to the full legacy grid representation
+         */
+        unique_ptr<MazeGrid> expand() const {
+            MazeGrid* grid = new MazeGrid(2 * maze_width + 1, 2 * maze_height + 1);
+            for (size_t j = 0; j < grid->height(); ++j) expand_row(j, grid->row(j));
+            return unique_ptr<MazeGrid>{grid};
+        }
+};
+
+#endif
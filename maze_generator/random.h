@@ -0,0 +1,153 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <random>
+#include <limits>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+
+/**
+ * Random number generation shared by the generators
+ * Any engine of the standard library works wherever a URNG is taken, as long
+ * as it returns 32 or 64 random bits starting from 0 (std::mt19937,
+ * std::mt19937_64, xoshiro256).
+ */
+
+/**
+ * Advance a splitmix64 state and return its next output
+ * Used to expand one seed into the state of a larger engine
+ */
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * xoshiro256** engine, 32 bytes of state and a handful of instructions per
+ * 64-bit output
+ * Seeds are expanded with splitmix64, so every seed including 0 gives a
+ * usable state.
+ */
+class xoshiro256 {
+    private:
+        uint64_t state[4];
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+    public:
+        typedef uint64_t result_type;
+
+        explicit xoshiro256(uint64_t seed_value=0) { seed(seed_value); }
+        void seed(uint64_t seed_value) {
+            for (int i = 0; i < 4; ++i) state[i] = splitmix64(seed_value);
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+        result_type operator()() {
+            uint64_t result = rotl(state[1] * 5, 7) * 9;
+            uint64_t t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotl(state[3], 45);
+            return result;
+        }
+};
+
+/**
+ * Draw a fresh seed from the hardware random device
+ */
+inline uint64_t random_seed() {
+    std::random_device rd;
+    return (uint64_t) rd() << 32 ^ rd();
+}
+
+/**
+ * Draw 64 random bits, from two calls to 32-bit engines
+ */
+template <class URNG>
+inline uint64_t random_bits64(URNG& gen) {
+    if (URNG::max() >= std::numeric_limits<uint64_t>::max()) return (uint64_t) gen();
+    uint64_t high = (uint32_t) gen();
+    return high << 32 | (uint32_t) gen();
+}
+
+/**
+ * Draw an integer in [0, n) with a single call to the generator
+ * Multiply-shift keeps the bias below n / 2^32 without a modulo or a
+ * rejection loop
+ */
+template <class URNG>
+inline uint32_t bounded_draw(URNG& gen, uint32_t n) {
+    return (uint32_t) (((uint64_t) (uint32_t) gen() * n) >> 32);
+}
+
+/**
+ * Draw an integer in [0, n) for any n, with a bias below n / 2^64
+ */
+template <class URNG>
+inline uint64_t bounded_draw64(URNG& gen, uint64_t n) {
+    uint64_t bits = random_bits64(gen);
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef unsigned __int128 uint128;
+    return (uint64_t) (((uint128) bits * n) >> 64);
+#else
+    uint64_t bits_lo = (uint32_t) bits, bits_hi = bits >> 32, n_lo = (uint32_t) n, n_hi = n >> 32;
+    uint64_t cross = (bits_lo * n_lo >> 32) + (uint32_t) (bits_hi * n_lo) + bits_lo * n_hi;
+    return bits_hi * n_hi + (bits_hi * n_lo >> 32) + (cross >> 32);
+#endif
+}
+
+/**
+ * Shuffle a range with Fisher-Yates and bounded draws, cheaper than
+ * std::shuffle which goes through a uniform_int_distribution per element
+ */
+template <class RandomIt, class URNG>
+void shuffle_range(RandomIt first, RandomIt last, URNG& gen) {
+    size_t n = (size_t) (last - first);
+    for (size_t i = n; i > 1; --i) {
+        size_t j = i <= std::numeric_limits<uint32_t>::max() ? bounded_draw(gen, (uint32_t) i)
+            : (size_t) bounded_draw64(gen, i);
+        std::swap(first[i - 1], first[j]);
+    }
+}
+
+/**
+ * Hands out a few random bits at a time from 64-bit draws, for coin flips and
+ * directions
+ */
+template <class URNG>
+class random_bits {
+    private:
+        URNG& gen;
+        uint64_t bits;
+        int left;
+    public:
+        explicit random_bits(URNG& gen) : gen(gen), bits(0), left(0) {}
+
+        /**
+         * @param count number of bits, at most 32
+         */
+        uint32_t next(int count) {
+            if (left < count) {
+                bits = random_bits64(gen);
+                left = 64;
+            }
+            uint32_t result = (uint32_t) (bits & ((1ULL << count) - 1));
+            bits >>= count;
+            left -= count;
+            return result;
+        }
+        bool coin() { return next(1) != 0; }
+};
+
+#endif
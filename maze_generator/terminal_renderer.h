@@ -0,0 +1,180 @@
+#ifndef TERMINAL_RENDERER_H
+#define TERMINAL_RENDERER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "maze_grid.h"
+#include "packed_maze.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+
+// size and rows of the legacy grid of either maze type
+inline size_t grid_slot_width(const MazeGrid& grid) { return grid.width(); }
+inline size_t grid_slot_width(const PackedMaze& maze) { return 2 * maze.cell_width() + 1; }
+inline size_t grid_slot_height(const MazeGrid& grid) { return grid.height(); }
+inline size_t grid_slot_height(const PackedMaze& maze) { return 2 * maze.cell_height() + 1; }
+
+inline const uint8_t* grid_row(const MazeGrid& grid, size_t j, uint8_t*) {
+    return grid.row(j);
+}
+
+inline const uint8_t* grid_row(const PackedMaze& maze, size_t j, uint8_t* buffer) {
+    maze.expand_row(j, buffer);
+    return buffer;
+}
+
+/**
+ * Draws frames of grid slots to a terminal
+ * A frame is built in one reused buffer from a fixed glyph table indexed by
+ * slot value (0 path, 1 wall, 2 on path, 3 start, 4 end, 5 visited, any
+ * other value a fallback glyph) and sent with a single write.
+ *
+ * In diff mode the first frame clears the screen and every later frame only
+ * sends the runs of slots that changed since the last frame drawn, each after
+ * an ANSI cursor move. With a frame rate limit, frames that come in faster
+ * than the limit are skipped unless forced.
+ */
+class terminal_renderer {
+    private:
+        typedef std::chrono::steady_clock clock;
+        static const int glyph_count = 7; // the last one is drawn for unknown slot values
+
+        const char* glyphs[glyph_count];
+        size_t glyph_lengths[glyph_count];
+        bool diff;
+        clock::duration min_interval;
+        clock::time_point last_frame;
+        bool drawn; // whether a diff frame is on screen
+        FILE* out;
+
+        string frame;
+        vector<uint8_t> previous; // slots of the last frame drawn in diff mode
+        vector<uint8_t> buffer;
+        size_t frame_width;
+        size_t frame_height;
+        size_t next_row;
+
+        void append_slots(const uint8_t* slots, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                int glyph = std::min<int>(slots[i], glyph_count - 1);
+                frame.append(glyphs[glyph], glyph_lengths[glyph]);
+            }
+        }
+        void move_cursor(size_t row, size_t column) {
+            char escape[48];
+            int length = std::snprintf(escape, sizeof(escape), "\033[%zu;%zuH", row + 1, column + 1);
+            frame.append(escape, length);
+        }
+    public:
+        /**
+         * @param colors enable colors for terminals that support it
+         * @param visited indicate visited cells even if they are not on the path
+         * @param diff only send the slots that changed since the last frame
+         * @param max_fps frame rate limit, 0 draws every frame
+         * @param out stream to write frames to
+         */
+        explicit terminal_renderer(bool colors=false, bool visited=false, bool diff=false, double max_fps=0,
+            FILE* out=stdout) : diff(diff), min_interval(0), drawn(false), out(out), frame_width(0),
+            frame_height(0), next_row(0) {
+            static const char* plain[glyph_count] = {"  ", "██", "◀▶", "SS", "EE", "  ", "??"};
+            static const char* colored[glyph_count] = {"  ", "██", "\033[1;35m██\033[0m",
+                "\033[1;31m██\033[0m", "\033[1;32m██\033[0m", "  ", "??"};
+            for (int i = 0; i < glyph_count; ++i) glyphs[i] = colors ? colored[i] : plain[i];
+            if (visited) glyphs[5] = colors ? "\033[1;34m██\033[0m" : "..";
+            for (int i = 0; i < glyph_count; ++i) glyph_lengths[i] = std::strlen(glyphs[i]);
+            if (max_fps > 0)
+                min_interval = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1 / max_fps));
+        }
+
+        // whether enough time has passed since the last frame for the rate limit
+        bool frame_due() const {
+            return min_interval == clock::duration(0) || clock::now() - last_frame >= min_interval;
+        }
+        /**
+         * Forget the last frame, so the next diff frame clears the screen and draws everything
+         */
+        void restart() {
+            drawn = false;
+        }
+
+        /**
+         * Start a frame of width x height slots, rows are then added from the top
+         */
+        void begin_frame(size_t width, size_t height) {
+            if (drawn && (width != frame_width || height != frame_height)) drawn = false;
+            frame_width = width;
+            frame_height = height;
+            next_row = 0;
+            frame.clear();
+            if (diff && !drawn) {
+                previous.assign(width * height, 0);
+                frame.append("\033[2J\033[H");
+            }
+            size_t widest = *std::max_element(glyph_lengths, glyph_lengths + glyph_count);
+            if (!drawn) frame.reserve(height * (width * widest + 1) + 64);
+        }
+        void add_row(const uint8_t* slots) {
+            size_t j = next_row++;
+            if (!diff || !drawn) {
+                append_slots(slots, frame_width);
+                frame.push_back('\n');
+                if (diff) std::copy(slots, slots + frame_width, previous.begin() + j * frame_width);
+                return;
+            }
+            uint8_t* old = previous.data() + j * frame_width;
+            if (std::memcmp(old, slots, frame_width) == 0) return;
+            for (size_t i = 0; i < frame_width; ) {
+                if (old[i] == slots[i]) {
+                    ++i;
+                    continue;
+                }
+                size_t first = i;
+                while (i < frame_width && old[i] != slots[i]) ++i;
+                move_cursor(j, 2 * first); // every glyph is two columns wide
+                append_slots(slots + first, i - first);
+                std::copy(slots + first, slots + i, old + first);
+            }
+        }
+        /**
+         * Send the frame with a single write
+         */
+        void end_frame() {
+            if (diff) {
+                if (drawn) move_cursor(frame_height, 0); // leave the cursor below the maze
+                drawn = true;
+            }
+            std::fflush(out);
+            std::fwrite(frame.data(), 1, frame.size(), out);
+            std::fflush(out);
+            last_frame = clock::now();
+        }
+
+        /**
+         * Draw a maze as one frame
+         *
+         * @param force draw even if the frame rate limit would skip it
+         * @return whether the frame was drawn
+         */
+        template <class Maze>
+        bool draw(const Maze& maze, bool force=false) {
+            if (!force && !frame_due()) return false;
+            size_t width = grid_slot_width(maze), height = grid_slot_height(maze);
+            buffer.resize(width);
+            begin_frame(width, height);
+            for (size_t j = 0; j < height; ++j) add_row(grid_row(maze, j, buffer.data()));
+            end_frame();
+            return true;
+        }
+};
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef THREADING_H
+#define THREADING_H
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+using std::size_t;
+using std::vector;
+using std::unique_ptr;
+
+/**
+ * Get the number of threads to use, where 0 means one per hardware thread
+ */
+inline size_t resolve_thread_count(size_t threads) {
+    if (threads > 0) return threads;
+    size_t hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * Reusable barrier for a fixed number of threads
+ */
+class thread_barrier {
+    private:
+        std::mutex mutex;
+        std::condition_variable released;
+        size_t count;
+        size_t waiting;
+        size_t generation;
+    public:
+        explicit thread_barrier(size_t count) : count(count), waiting(0), generation(0) {}
+        /**
+         * Block until all threads have called wait for the current generation
+         */
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            size_t current = generation;
+            if (++waiting == count) {
+                waiting = 0;
+                generation++;
+                released.notify_all();
+            }
+            else released.wait(lock, [&] { return generation != current; });
+        }
+};
+
+/**
+ * Thread pool where every worker has its own task deque
+ * Tasks submitted from a worker go onto the back of its own deque and it takes
+ * from the back, so related work stays on one thread; idle workers steal from
+ * the front of other deques
+ */
+class work_stealing_pool {
+    private:
+        struct task_queue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        vector<unique_ptr<task_queue>> queues;
+        vector<std::thread> workers;
+        std::atomic<size_t> pending; // tasks submitted and not yet finished
+        std::atomic<size_t> queued; // tasks submitted and not yet taken, raised under sleep_mutex
+        std::atomic<size_t> next_queue; // round robin queue for submissions from other threads
+        std::atomic<bool> stopping;
+        std::mutex sleep_mutex;
+        std::condition_variable wake; // signaled when tasks are submitted
+        std::condition_variable idle; // signaled when pending drops to 0
+
+        struct worker_identity {
+            const work_stealing_pool* pool;
+            size_t index;
+        };
+        // pool and queue of the worker running on this thread, if any
+        static worker_identity& current_worker() {
+            static thread_local worker_identity identity = {nullptr, 0};
+            return identity;
+        }
+
+        bool pop_task(size_t self, std::function<void()>& task) {
+            { // own deque, newest first
+                std::lock_guard<std::mutex> lock(queues[self]->mutex);
+                if (!queues[self]->tasks.empty()) {
+                    task = std::move(queues[self]->tasks.back());
+                    queues[self]->tasks.pop_back();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < queues.size(); ++i) { // steal oldest from the others
+                task_queue& victim = *queues[(self + i) % queues.size()];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run(size_t self) {
+            current_worker().pool = this;
+            current_worker().index = self;
+            std::function<void()> task;
+            while (true) {
+                if (pop_task(self, task)) {
+                    queued--;
+                    task();
+                    task = nullptr;
+                    if (--pending == 0) {
+                        std::lock_guard<std::mutex> lock(sleep_mutex);
+                        idle.notify_all();
+                    }
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mutex);
+                // submit counts a task under the lock before it notifies, so no wakeup is lost
+                wake.wait(lock, [&] { return stopping || queued > 0; });
+                if (stopping) return;
+            }
+        }
+    public:
+        explicit work_stealing_pool(size_t threads=0) : pending(0), queued(0), next_queue(0), stopping(false) {
+            threads = resolve_thread_count(threads);
+            for (size_t i = 0; i < threads; ++i) queues.push_back(unique_ptr<task_queue>(new task_queue()));
+            for (size_t i = 0; i < threads; ++i) workers.push_back(std::thread(&work_stealing_pool::run, this, i));
+        }
+        ~work_stealing_pool() {
+            wait();
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                stopping = true;
+                wake.notify_all();
+            }
+            for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+        }
+        size_t size() const {
+            return workers.size();
+        }
+        void submit(std::function<void()> task) {
+            pending++;
+            {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                queued++;
+            }
+            const worker_identity& self = current_worker();
+            size_t queue = self.pool == this ? self.index : next_queue++ % queues.size();
+            {
+                std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+                queues[queue]->tasks.push_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+        /**
+         * Block until every submitted task, including ones submitted by tasks, has finished
+         * Must not be called from a worker of this pool
+         */
+        void wait() {
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            idle.wait(lock, [&] { return pending == 0; });
+        }
+};
+
+#endif
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <algorithm>
+#include "corridor_graph.h"
+#include "../maze_generator/maze_walk.h"
+
+using std::cerr;
+
+static const uint8_t no_direction = 0xFF;
+
+template <class Maze>
+const uint32_t CorridorGraph<Maze>::absent;
+
+/**
+ * Nodes are found in three passes: cells without exactly two openings, then
+ * every corridor cell reachable from them is marked, and any corridor cell
+ * left unmarked is on a ring without junctions, so it becomes a node too.
+ * The edges are then walked once more from every node in cell order.
+ */
+template <class Maze>
+CorridorGraph<Maze>::CorridorGraph(const Maze& maze)
+    : maze(&maze), width(maze.cell_width()), height(maze.cell_height()) {
+    size_t cells = width * height;
+    if (cells >= (size_t) absent) {
+        cerr << "ERROR: maze is too large for 32-bit cell indices!\n";
+        width = height = cells = 0;
+    }
+    node_flags.assign(cells, false);
+    for (size_t cell = 0; cell < cells; ++cell) {
+        int openings = 0;
+        for (int i = 0; i < 4; ++i) openings += open(cell, (Direction) i);
+        node_flags[cell] = openings != 2;
+    }
+    vector<bool> covered(cells, false);
+    auto cover = [&](size_t node) {
+        for (int i = 0; i < 4; ++i) {
+            if (!open(node, (Direction) i)) continue;
+            vector<size_t> corridor;
+            expand(node, (Direction) i, walk(node, (Direction) i).cell, corridor);
+            for (size_t cell : corridor) covered[cell] = true;
+        }
+    };
+    for (size_t cell = 0; cell < cells; ++cell)
+        if (node_flags[cell]) cover(cell);
+    for (size_t cell = 0; cell < cells; ++cell) {
+        if (node_flags[cell] || covered[cell]) continue;
+        node_flags[cell] = true;
+        cover(cell);
+    }
+
+    for (size_t cell = 0; cell < cells; ++cell)
+        if (node_flags[cell]) node_cells.push_back((uint32_t) cell);
+    edge_offsets.push_back(0);
+    for (uint32_t node_cell : node_cells) {
+        for (int i = 0; i < 4; ++i) {
+            if (!open(node_cell, (Direction) i)) continue;
+            corridor_end end = walk(node_cell, (Direction) i);
+            if (end.cell == node_cell) continue; // a corridor back to the same node is never useful
+            edge_targets.push_back(find_node(end.cell));
+            edge_lengths.push_back(end.length);
+            edge_directions.push_back((uint8_t) i);
+        }
+        edge_offsets.push_back((uint32_t) edge_targets.size());
+    }
+}
+
+template <class Maze>
+size_t CorridorGraph<Maze>::bytes() const {
+    return node_flags.size() / 8 + (node_cells.size() + edge_offsets.size() + edge_targets.size()
+        + edge_lengths.size()) * sizeof(uint32_t) + edge_directions.size();
+}
+
+template <class Maze>
+uint32_t CorridorGraph<Maze>::find_node(size_t cell) const {
+    vector<uint32_t>::const_iterator node = std::lower_bound(node_cells.begin(), node_cells.end(), (uint32_t) cell);
+    if (node == node_cells.end() || *node != cell) return absent;
+    return (uint32_t) (node - node_cells.begin());
+}
+
+template <class Maze>
+bool CorridorGraph<Maze>::open(size_t cell, Direction dir) const {
+    return has_opening(*maze, cell, dir);
+}
+
+template <class Maze>
+typename CorridorGraph<Maze>::corridor_end CorridorGraph<Maze>::walk(size_t cell, Direction dir, size_t stop) const {
+    Direction last = dir;
+    size_t current = cell + neighbor_offset(dir, width);
+    uint32_t length = 1;
+    while (current != stop && !node_flags[current]) { // cells that are not nodes have two openings
+        current = corridor_step(*maze, current, last);
+        length++;
+    }
+    return corridor_end{(uint32_t) current, length, (uint8_t) dir, (uint8_t) ((last + 2) % 4)};
+}
+
+template <class Maze>
+void CorridorGraph<Maze>::corridor_ends(size_t cell, corridor_end ends[2], size_t stop) const {
+    int found = 0;
+    for (int i = 0; i < 4 && found < 2; ++i)
+        if (open(cell, (Direction) i)) ends[found++] = walk(cell, (Direction) i, stop);
+}
+
+template <class Maze>
+void CorridorGraph<Maze>::expand(size_t cell, Direction dir, size_t target, vector<size_t>& path) const {
+    Direction last = dir;
+    size_t current = cell + neighbor_offset(dir, width);
+    path.push_back(current);
+    while (current != target) {
+        current = corridor_step(*maze, current, last);
+        path.push_back(current);
+    }
+}
+
+template <class Maze>
+CorridorSearchContext<Maze>::CorridorSearchContext(const CorridorGraph<Maze>& graph)
+    : graph(&graph), epoch(0), epochs(graph.nodes() + 2, 0), g_scores(graph.nodes() + 2),
+    predecessors(graph.nodes() + 2), directions(graph.nodes() + 2), discovered(graph.nodes() + 2),
+    expanded_nodes(0) {}
+
+template <class Maze>
+void CorridorSearchContext<Maze>::next_epoch() {
+    discovered.clear();
+    if (++epoch == 0) {
+        // the counter wrapped, so old epochs could collide with new ones
+        std::fill(epochs.begin(), epochs.end(), 0);
+        epoch = 1;
+    }
+}
+
+template <class Maze>
+void CorridorSearchContext<Maze>::relax(uint32_t node, uint32_t g_score, uint32_t predecessor, uint8_t direction,
+    double heuristic) {
+    if (reached(node) && g_score >= g_scores[node]) return;
+    epochs[node] = epoch;
+    g_scores[node] = g_score;
+    predecessors[node] = predecessor;
+    directions[node] = direction;
+    discovered.push_or_decrease(node, key{g_score + heuristic, g_score});
+}
+
+template <class Maze>
+bool CorridorSearchContext<Maze>::find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+    vector<size_t>& path, string heuristic) {
+    size_t width = graph->cell_width(), height = graph->cell_height();
+    path.clear();
+    expanded_nodes = 0;
+    if (startX >= width || startY >= height || endX >= width || endY >= height) {
+        cerr << "ERROR: A* coordinates out of bounds!\n";
+        return false;
+    }
+    int heuristic_index = parse_heuristic(heuristic);
+    auto estimate = [&](size_t cell) { return a_star_heuristic(cell % width, cell / width, endX, endY, heuristic_index); };
+    size_t start = startY * width + startX, end = endY * width + endX;
+    uint32_t start_node = (uint32_t) graph->nodes(), end_node = start_node + 1; // virtual nodes
+    if (start == end) {
+        path.push_back(start);
+        return true;
+    }
+    next_epoch();
+    epochs[start_node] = epoch;
+    g_scores[start_node] = 0;
+
+    // nodes at the ends of the corridor holding the end, if it is not a node
+    uint32_t goal = end_node;
+    typename CorridorGraph<Maze>::corridor_end goal_ends[2];
+    if (graph->is_node(end)) goal = graph->find_node(end);
+    else graph->corridor_ends(end, goal_ends);
+    // join the start to the graph, or straight to the end if they share a corridor
+    typename CorridorGraph<Maze>::corridor_end ends[2];
+    if (graph->is_node(start)) relax(graph->find_node(start), 0, start_node, no_direction, estimate(start));
+    else {
+        graph->corridor_ends(start, ends, end);
+        for (int k = 0; k < 2; ++k) {
+            uint32_t node = ends[k].cell == end ? goal : graph->find_node(ends[k].cell);
+            relax(node, ends[k].length, start_node, ends[k].leave, estimate(ends[k].cell));
+        }
+    }
+
+    while (!discovered.empty()) {
+        uint32_t current = discovered.top();
+        discovered.pop();
+        expanded_nodes++;
+        if (current == goal) {
+            vector<uint32_t> hops;
+            for (; current != start_node; current = predecessors[current]) hops.push_back(current);
+            path.push_back(start);
+            for (size_t i = hops.size(); i-- > 0; ) {
+                if (directions[hops[i]] == no_direction) continue; // the start is a node
+                size_t target = hops[i] == end_node ? end : graph->node_cell(hops[i]);
+                graph->expand(path.back(), (Direction) directions[hops[i]], target, path);
+            }
+            return true;
+        }
+        for (uint32_t edge = graph->first_edge(current); edge < graph->last_edge(current); ++edge) {
+            uint32_t target = graph->edge_target(edge);
+            relax(target, g_scores[current] + graph->edge_length(edge), current,
+                (uint8_t) graph->edge_direction(edge), estimate(graph->node_cell(target)));
+        }
+        if (goal == end_node)
+            for (int k = 0; k < 2; ++k)
+                if (goal_ends[k].cell == graph->node_cell(current))
+                    relax(end_node, g_scores[current] + goal_ends[k].length, current, goal_ends[k].arrive, 0);
+    }
+    cerr << "No path found!\n";
+    return false;
+}
+
+template class CorridorGraph<MazeGrid>;
+template class CorridorGraph<PackedMaze>;
+template class CorridorSearchContext<MazeGrid>;
+template class CorridorSearchContext<PackedMaze>;
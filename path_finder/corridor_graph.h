@@ -0,0 +1,133 @@
+#ifndef CORRIDOR_GRAPH_H
+#define CORRIDOR_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "indexed_heap.h"
+#include "path_search_context.h"
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+using std::uint32_t;
+
+/**
+ * Maze collapsed to a weighted graph of its junctions and dead ends
+ * Every cell without exactly two openings is a node, and every corridor of
+ * two-opening cells between two nodes is one edge weighted by its length.
+ * Rings of corridor cells with no junction get one of their cells as a node.
+ *
+ * Edges are kept in compressed sparse row form: the edges of node i are
+ * edge_offsets[i]..edge_offsets[i+1] in the target, length and direction
+ * arrays, where the direction is the one the corridor leaves node i in.
+ * The maze is kept by reference to walk corridors back out into cells.
+ * Defined for MazeGrid and PackedMaze.
+ */
+template <class Maze>
+class CorridorGraph {
+    public:
+        static const uint32_t absent = std::numeric_limits<uint32_t>::max();
+        /**
+         * One end of the corridor through a cell that is not a node
+         */
+        struct corridor_end {
+            uint32_t cell; // node cell, or the stop cell if the walk reached it first
+            uint32_t length; // steps from the cell
+            uint8_t leave; // direction the walk left the starting cell in
+            uint8_t arrive; // direction from the end cell back into the corridor
+        };
+    private:
+        const Maze* maze;
+        size_t width;
+        size_t height;
+        vector<bool> node_flags; // by cell
+        vector<uint32_t> node_cells; // cell of each node, in increasing order
+        vector<uint32_t> edge_offsets;
+        vector<uint32_t> edge_targets;
+        vector<uint32_t> edge_lengths;
+        vector<uint8_t> edge_directions;
+    public:
+        explicit CorridorGraph(const Maze& maze);
+
+        const Maze& get_maze() const { return *maze; }
+        size_t cell_width() const { return width; }
+        size_t cell_height() const { return height; }
+        size_t nodes() const { return node_cells.size(); }
+        size_t edges() const { return edge_targets.size(); }
+        // bytes used by the graph
+        size_t bytes() const;
+
+        bool is_node(size_t cell) const { return node_flags[cell]; }
+        size_t node_cell(size_t node) const { return node_cells[node]; }
+        // node of a cell, absent if the cell is inside a corridor
+        uint32_t find_node(size_t cell) const;
+        uint32_t first_edge(size_t node) const { return edge_offsets[node]; }
+        uint32_t last_edge(size_t node) const { return edge_offsets[node + 1]; }
+        uint32_t edge_target(size_t edge) const { return edge_targets[edge]; }
+        uint32_t edge_length(size_t edge) const { return edge_lengths[edge]; }
+        Direction edge_direction(size_t edge) const { return (Direction) edge_directions[edge]; }
+
+        // whether a cell has a neighbor in a direction with no wall between them
+        bool open(size_t cell, Direction dir) const;
+        /**
+         * Walk from a cell in a direction until a node or the stop cell
+         */
+        corridor_end walk(size_t cell, Direction dir, size_t stop=absent) const;
+        /**
+         * Both ends of the corridor through a cell that is not a node
+         */
+        void corridor_ends(size_t cell, corridor_end ends[2], size_t stop=absent) const;
+        /**
+         * Append the cells walked from a cell in a direction up to and including target
+         */
+        void expand(size_t cell, Direction dir, size_t target, vector<size_t>& path) const;
+};
+
+/**
+ * Reusable A* state over a CorridorGraph, one per thread
+ * Query endpoints inside corridors are joined to the two nodes at the ends of
+ * their corridor as virtual start and end nodes, and the path is only walked
+ * out into cells once the end is reached. Buffers are reset lazily by epoch
+ * as in PathSearchContext.
+ */
+template <class Maze>
+class CorridorSearchContext {
+    private:
+        typedef typename PathSearchContext<Maze>::key key;
+        const CorridorGraph<Maze>* graph;
+        uint32_t epoch;
+        vector<uint32_t> epochs; // by node, then the virtual start and end
+        vector<uint32_t> g_scores;
+        vector<uint32_t> predecessors;
+        vector<uint8_t> directions; // direction the step from the predecessor left it in
+        indexed_heap<key> discovered;
+        size_t expanded_nodes;
+
+        bool reached(uint32_t node) const { return epochs[node] == epoch; }
+        void next_epoch();
+        void relax(uint32_t node, uint32_t g_score, uint32_t predecessor, uint8_t direction, double heuristic);
+    public:
+        explicit CorridorSearchContext(const CorridorGraph<Maze>& graph);
+
+        /**
+         * Find a shortest path by searching the graph
+         *
+         * @param path filled with the cell indices (y * width + x) from start to end
+         * @param heuristic heuristic to use (manhattan, euclidean, none)
+         * @return whether a path was found
+         */
+        bool find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+            vector<size_t>& path, string heuristic="manhattan");
+
+        // number of graph nodes expanded by the last query
+        size_t expanded() const { return expanded_nodes; }
+};
+
+#endif
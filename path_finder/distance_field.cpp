@@ -0,0 +1,161 @@
+#include <iostream>
+#include <algorithm>
+#include "distance_field.h"
+#include "../maze_generator/maze_walk.h"
+
+using std::cerr;
+using std::uint64_t;
+
+/**
+ * Flat queue breadth-first search, each cell is queued at most once
+ */
+template <class Maze>
+static void queue_distances(const Maze& maze, const vector<size_t>& sources, vector<uint32_t>& distances) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    ptrdiff_t neighbor_offsets[] = {-1, -(ptrdiff_t) width, 1, (ptrdiff_t) width}; // index offsets
+    vector<uint32_t> queue(width * height);
+    size_t head = 0, tail = 0;
+    for (size_t source : sources) {
+        if (distances[source] == 0) continue;
+        distances[source] = 0;
+        queue[tail++] = (uint32_t) source;
+    }
+    while (head < tail) {
+        uint32_t current = queue[head++];
+        size_t x = current % width, y = current / width;
+        uint32_t distance = distances[current] + 1;
+        for (int i = 0; i < 4; ++i) {
+            if (!has_opening(maze, x, y, (Direction) i)) continue;
+            uint32_t neighbor = (uint32_t) (current + neighbor_offsets[i]);
+            if (distances[neighbor] != unreachable_distance) continue;
+            distances[neighbor] = distance;
+            queue[tail++] = neighbor;
+        }
+    }
+}
+
+/**
+ * Level-synchronous breadth-first search over bitsets
+ * Every row of cells is a run of 64-bit words. The open east and south walls
+ * are read from the maze once into bitsets, then each level moves a word of
+ * frontier cells one cell east or west with shifts and one row north or south
+ * with ands. Only words holding frontier cells and the words next to them are
+ * touched on each level.
+ */
+template <class Maze>
+static void bitset_distances(const Maze& maze, const vector<size_t>& sources, vector<uint32_t>& distances) {
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    size_t words = (width + 63) / 64; // words per row
+    vector<uint64_t> open_east(words * height, 0), open_west(words * height, 0), open_south(words * height, 0);
+    for (size_t y = 0; y < height; ++y)
+        for (size_t x = 0; x < width; ++x) {
+            uint64_t bit = (uint64_t) 1 << (x % 64);
+            size_t word = y * words + x / 64;
+            if (x + 1 < width && !maze.has_wall(x, y, EAST)) {
+                open_east[word] |= bit;
+                open_west[y * words + (x + 1) / 64] |= (uint64_t) 1 << ((x + 1) % 64);
+            }
+            if (y + 1 < height && !maze.has_wall(x, y, SOUTH)) open_south[word] |= bit;
+        }
+
+    vector<uint64_t> visited(words * height, 0), current(words * height, 0), next(words * height, 0);
+    vector<size_t> active, touched; // words with frontier cells, words that may get some next level
+    vector<uint8_t> word_touched(words * height, 0);
+    auto touch = [&](size_t word) {
+        if (!word_touched[word]) touched.push_back(word);
+        word_touched[word] = 1;
+    };
+    auto record = [&](size_t word, uint32_t distance) {
+        size_t first = word / words * width + word % words * 64;
+        for (uint64_t bits = current[word]; bits != 0; bits &= bits - 1)
+            distances[first + __builtin_ctzll(bits)] = distance;
+    };
+    for (size_t source : sources) {
+        size_t word = source / width * words + source % width / 64;
+        uint64_t bit = (uint64_t) 1 << (source % width % 64);
+        current[word] |= bit;
+        visited[word] |= bit;
+        touch(word);
+    }
+    active.swap(touched);
+    for (size_t word : active) {
+        record(word, 0);
+        word_touched[word] = 0;
+    }
+
+    for (uint32_t distance = 1; !active.empty(); ++distance) {
+        for (size_t word : active) {
+            uint64_t frontier = current[word];
+            size_t column = word % words;
+            uint64_t east = frontier & open_east[word], west = frontier & open_west[word];
+            next[word] |= (east << 1) | (west >> 1);
+            touch(word);
+            if ((east >> 63) && column + 1 < words) {
+                next[word + 1] |= 1;
+                touch(word + 1);
+            }
+            if ((west & 1) && column > 0) {
+                next[word - 1] |= (uint64_t) 1 << 63;
+                touch(word - 1);
+            }
+            if (uint64_t south = frontier & open_south[word]) {
+                next[word + words] |= south;
+                touch(word + words);
+            }
+            if (word >= words) {
+                if (uint64_t north = frontier & open_south[word - words]) {
+                    next[word - words] |= north;
+                    touch(word - words);
+                }
+            }
+            current[word] = 0;
+        }
+        current.swap(next);
+        active.clear();
+        for (size_t word : touched) {
+            word_touched[word] = 0;
+            current[word] &= ~visited[word];
+            if (current[word] == 0) continue;
+            visited[word] |= current[word];
+            record(word, distance);
+            active.push_back(word);
+        }
+        touched.clear();
+    }
+}
+
+template <class Maze>
+unique_ptr<vector<uint32_t>> distance_field(const Maze& maze, const vector<size_t>& sources, string frontier) {
+    size_t cells = maze.cell_width() * maze.cell_height();
+    if (cells >= (size_t) unreachable_distance) {
+        cerr << "ERROR: maze is too large for 32-bit distances!\n";
+        return unique_ptr<vector<uint32_t>>();
+    }
+    for (size_t source : sources) {
+        if (source >= cells) {
+            cerr << "ERROR: distance field source out of bounds!\n";
+            return unique_ptr<vector<uint32_t>>();
+        }
+    }
+    vector<uint32_t>* distances = new vector<uint32_t>(cells, unreachable_distance);
+    if (frontier == "bitset") bitset_distances(maze, sources, *distances);
+    else {
+        if (frontier != "queue") cerr << "ERROR: Invalid distance field frontier!\n";
+        queue_distances(maze, sources, *distances);
+    }
+    return unique_ptr<vector<uint32_t>>{distances};
+}
+
+template <class Maze>
+unique_ptr<vector<uint32_t>> distance_field(const Maze& maze, size_t sourceX, size_t sourceY, string frontier) {
+    if (sourceX >= maze.cell_width() || sourceY >= maze.cell_height()) {
+        cerr << "ERROR: distance field source out of bounds!\n";
+        return unique_ptr<vector<uint32_t>>();
+    }
+    return distance_field(maze, vector<size_t>(1, sourceY * maze.cell_width() + sourceX), frontier);
+}
+
+template unique_ptr<vector<uint32_t>> distance_field(const MazeGrid&, const vector<size_t>&, string);
+template unique_ptr<vector<uint32_t>> distance_field(const PackedMaze&, const vector<size_t>&, string);
+template unique_ptr<vector<uint32_t>> distance_field(const MazeGrid&, size_t, size_t, string);
+template unique_ptr<vector<uint32_t>> distance_field(const PackedMaze&, size_t, size_t, string);
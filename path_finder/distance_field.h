@@ -0,0 +1,44 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint32_t;
+using std::unique_ptr;
+
+// distance of cells that cannot be reached from any source
+const uint32_t unreachable_distance = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Breadth-first distances from a set of sources to every cell
+ * Distances are in steps between cells and indexed by y * width + x. In a
+ * perfect maze there is one path between any two cells, so this gives the
+ * exact path length to every cell at once instead of one A* search per cell.
+ * Defined for MazeGrid and PackedMaze.
+ *
+ * @param sources cell indices at distance 0
+ * @param frontier "queue" expands one cell at a time from a flat queue,
+ *                 "bitset" expands the whole frontier a level at a time as rows
+ *                 of 64-bit words, which is faster when the frontier is wide
+ * @return width * height distances, empty on invalid input
+ */
+template <class Maze>
+unique_ptr<vector<uint32_t>> distance_field(const Maze& maze, const vector<size_t>& sources,
+    string frontier="queue");
+
+template <class Maze>
+unique_ptr<vector<uint32_t>> distance_field(const Maze& maze, size_t sourceX, size_t sourceY,
+    string frontier="queue");
+
+#endif
@@ -0,0 +1,194 @@
+#include <iostream>
+#include <algorithm>
+#include "incremental_search.h"
+
+using std::cerr;
+
+template <class Maze>
+IncrementalPathSearch<Maze>::IncrementalPathSearch(Maze& maze, string heuristic)
+    : maze(&maze), width(maze.cell_width()), height(maze.cell_height()), heuristic(parse_heuristic(heuristic)),
+    start(0), goal(0), has_endpoints(false), epoch(0), expanded_cells(0) {}
+
+template <class Maze>
+bool IncrementalPathSearch<Maze>::set_endpoints(size_t startX, size_t startY, size_t endX, size_t endY) {
+    if (width * height >= (size_t) unreachable) {
+        cerr << "ERROR: maze is too large for 32-bit cell indices!\n";
+        return false;
+    }
+    if (startX >= width || startY >= height || endX >= width || endY >= height) {
+        cerr << "ERROR: A* coordinates out of bounds!\n";
+        return false;
+    }
+    if (epochs.empty()) { // allocated on first use, so edits alone cost nothing
+        epochs.assign(width * height, 0);
+        g_scores.resize(width * height);
+        rhs_scores.resize(width * height);
+        inconsistent.reset(width * height);
+    }
+    inconsistent.clear();
+    if (++epoch == 0) {
+        // the counter wrapped, so old epochs could collide with new ones
+        std::fill(epochs.begin(), epochs.end(), 0);
+        epoch = 1;
+    }
+    start = (uint32_t) (startY * width + startX);
+    goal = (uint32_t) (endY * width + endX);
+    has_endpoints = true;
+    touch(start);
+    rhs_scores[start] = 0;
+    enqueue(start);
+    return true;
+}
+
+template <class Maze>
+typename IncrementalPathSearch<Maze>::key IncrementalPathSearch<Maze>::cell_key(uint32_t cell) const {
+    uint32_t score = std::min(g(cell), rhs(cell));
+    if (score == unreachable) return key{std::numeric_limits<double>::infinity(), score};
+    return key{score + a_star_heuristic(cell % width, cell / width, goal % width, goal / width, heuristic), score};
+}
+
+template <class Maze>
+void IncrementalPathSearch<Maze>::recompute_rhs(uint32_t cell) {
+    uint32_t best = unreachable;
+    for (int dir = 0; dir < 4; ++dir)
+        if (open(cell, (Direction) dir)) {
+            uint32_t score = g(neighbor(cell, (Direction) dir));
+            if (score != unreachable && score + 1 < best) best = score + 1;
+        }
+    touch(cell);
+    rhs_scores[cell] = best;
+}
+
+// keep a cell in the heap exactly while its two scores differ
+template <class Maze>
+void IncrementalPathSearch<Maze>::enqueue(uint32_t cell) {
+    if (g(cell) != rhs(cell)) inconsistent.update(cell, cell_key(cell));
+    else if (inconsistent.contains(cell)) inconsistent.remove(cell);
+}
+
+/**
+ * Only the two cells on either side of the wall can have a different rhs
+ * score: opening a wall can lower either one to a step past the other, and
+ * closing it can only raise a cell whose rhs score came through it
+ */
+template <class Maze>
+bool IncrementalPathSearch<Maze>::edit_wall(size_t x, size_t y, Direction dir, bool wall) {
+    if (x >= width || y >= height) {
+        cerr << "ERROR: wall coordinates out of bounds!\n";
+        return false;
+    }
+    uint32_t cell = (uint32_t) (y * width + x);
+    if ((dir == WEST && x == 0) || (dir == NORTH && y == 0)
+        || (dir == EAST && x + 1 == width) || (dir == SOUTH && y + 1 == height)) {
+        cerr << "ERROR: border walls cannot be edited!\n";
+        return false;
+    }
+    if (maze->has_wall(x, y, dir) == wall) return true;
+    if (wall) maze->close_wall(x, y, dir);
+    else maze->open_wall(x, y, dir);
+    if (!has_endpoints) return true;
+
+    uint32_t cells[2] = {cell, neighbor(cell, dir)};
+    for (int k = 0; k < 2; ++k) {
+        uint32_t from = cells[k], to = cells[1 - k];
+        if (to == start || g(from) == unreachable) continue;
+        if (!wall && g(from) + 1 < rhs(to)) {
+            touch(to);
+            rhs_scores[to] = g(from) + 1;
+        }
+        else if (wall && rhs(to) == g(from) + 1) recompute_rhs(to);
+        else continue;
+        enqueue(to);
+    }
+    return true;
+}
+
+/**
+ * Expand inconsistent cells in key order until the goal is consistent and no
+ * cell left could improve it
+ * An overconsistent cell (g above rhs) takes its rhs score and can lower its
+ * neighbors; an underconsistent one (g below rhs) lost its path, so it is
+ * reset to unreachable and it and the neighbors that went through it look for
+ * another one
+ */
+template <class Maze>
+void IncrementalPathSearch<Maze>::repair() {
+    expanded_cells = 0;
+    while (!inconsistent.empty()
+        && (inconsistent.top_key() < cell_key(goal) || g(goal) != rhs(goal))) {
+        uint32_t current = inconsistent.top();
+        inconsistent.pop();
+        expanded_cells++;
+        uint32_t old_score = g(current);
+        if (old_score > rhs(current)) {
+            g_scores[current] = rhs_scores[current];
+            for (int dir = 0; dir < 4; ++dir) {
+                if (!open(current, (Direction) dir)) continue;
+                uint32_t next = neighbor(current, (Direction) dir);
+                if (next == start || g(current) + 1 >= rhs(next)) continue;
+                touch(next);
+                rhs_scores[next] = g(current) + 1;
+                enqueue(next);
+            }
+        }
+        else {
+            g_scores[current] = unreachable;
+            enqueue(current);
+            for (int dir = 0; dir < 4; ++dir) {
+                if (!open(current, (Direction) dir)) continue;
+                uint32_t next = neighbor(current, (Direction) dir);
+                if (next == start || rhs(next) != old_score + 1) continue;
+                recompute_rhs(next);
+                enqueue(next);
+            }
+        }
+    }
+}
+
+template <class Maze>
+uint32_t IncrementalPathSearch<Maze>::distance() {
+    if (!has_endpoints) {
+        cerr << "ERROR: no path endpoints set!\n";
+        return unreachable;
+    }
+    repair();
+    return g(goal);
+}
+
+/**
+ * Walks back from the goal through neighbors one step closer to the start,
+ * which the repair leaves consistent along a shortest path
+ */
+template <class Maze>
+bool IncrementalPathSearch<Maze>::find_path(vector<size_t>& path) {
+    path.clear();
+    uint32_t length = distance();
+    if (length == unreachable) {
+        if (has_endpoints) cerr << "No path found!\n";
+        return false;
+    }
+    path.resize((size_t) length + 1);
+    uint32_t current = goal;
+    for (size_t i = length; i > 0; --i) {
+        path[i] = current;
+        int dir = 0;
+        while (dir < 4 && !(open(current, (Direction) dir) && g(neighbor(current, (Direction) dir)) + 1 == g(current)))
+            ++dir;
+        current = neighbor(current, (Direction) dir);
+    }
+    path[0] = start;
+    return true;
+}
+
+template <class Maze>
+bool IncrementalPathSearch<Maze>::find_path(MazePath& path) {
+    bool found = find_path(cell_path);
+    if (!path.assign(cell_path, width)) {
+        cerr << "ERROR: path cells are not neighbors!\n";
+        return false;
+    }
+    return found;
+}
+
+template class IncrementalPathSearch<MazeGrid>;
+template class IncrementalPathSearch<PackedMaze>;
@@ -0,0 +1,140 @@
+#ifndef INCREMENTAL_SEARCH_H
+#define INCREMENTAL_SEARCH_H
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "indexed_heap.h"
+#include "maze_path.h"
+#include "path_search_context.h"
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+#include "../maze_generator/maze_walk.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint32_t;
+
+/**
+ * Shortest path between two fixed cells of a maze that is edited between
+ * queries, kept up to date with Lifelong Planning A* (LPA*)
+ * Walls are opened and closed through the search, which marks only the two
+ * cells on either side of the wall as inconsistent. The next query then
+ * repairs the g scores of the cells whose distance from the start changed
+ * and that can still lie on a shortest path to the goal, instead of searching
+ * again from scratch, so an edit close to the goal costs a handful of
+ * expansions.
+ *
+ * Every cell keeps its g score, the distance found by the last repair, and
+ * its rhs score, one more than the smallest g score of its open neighbors.
+ * Cells where the two differ are kept in an indexed heap. Buffers are reset
+ * lazily by epoch as in PathSearchContext, so new endpoints only touch the
+ * cells the new search reaches.
+ * Defined for MazeGrid and PackedMaze
+ */
+template <class Maze>
+class IncrementalPathSearch {
+    public:
+        static const uint32_t unreachable = std::numeric_limits<uint32_t>::max();
+        /**
+         * Heap key of an inconsistent cell, the f score of the smaller of its
+         * two scores and then that score
+         */
+        struct key {
+            double f_score;
+            uint32_t g_score;
+            bool operator<(const key& other) const {
+                return f_score < other.f_score || (f_score == other.f_score && g_score < other.g_score);
+            }
+        };
+    private:
+        Maze* maze;
+        size_t width;
+        size_t height;
+        int heuristic;
+        uint32_t start;
+        uint32_t goal;
+        bool has_endpoints;
+        uint32_t epoch; // current endpoints, cells with an older epoch are unreached
+        vector<uint32_t> epochs;
+        vector<uint32_t> g_scores;
+        vector<uint32_t> rhs_scores;
+        indexed_heap<key> inconsistent;
+        size_t expanded_cells;
+        vector<size_t> cell_path; // scratch for the compact find_path
+
+        uint32_t g(uint32_t cell) const { return epochs[cell] == epoch ? g_scores[cell] : unreachable; }
+        uint32_t rhs(uint32_t cell) const { return epochs[cell] == epoch ? rhs_scores[cell] : unreachable; }
+        // give a cell unreachable scores if the current search has not reached it yet
+        void touch(uint32_t cell) {
+            if (epochs[cell] == epoch) return;
+            epochs[cell] = epoch;
+            g_scores[cell] = rhs_scores[cell] = unreachable;
+        }
+        bool open(uint32_t cell, Direction dir) const { return has_opening(*maze, cell, dir); }
+        uint32_t neighbor(uint32_t cell, Direction dir) const {
+            return (uint32_t) (cell + neighbor_offset(dir, width));
+        }
+        key cell_key(uint32_t cell) const;
+        void recompute_rhs(uint32_t cell);
+        void enqueue(uint32_t cell);
+        bool edit_wall(size_t x, size_t y, Direction dir, bool wall);
+        void repair();
+    public:
+        /**
+         * @param heuristic heuristic to use (manhattan, euclidean, none)
+         */
+        explicit IncrementalPathSearch(Maze& maze, string heuristic="manhattan");
+
+        const Maze& get_maze() const { return *maze; }
+
+        /**
+         * Search between new endpoints, dropping every repaired score
+         * Coordinates are wrt the number of cells. The search itself runs on
+         * the next query.
+         *
+         * @return false if a coordinate is out of bounds
+         */
+        bool set_endpoints(size_t startX, size_t startY, size_t endX, size_t endY);
+
+        /**
+         * Open or close the wall of a cell in a direction, on the maze and in the search
+         * Walls already in the requested state are left alone.
+         *
+         * @return false if the cell is out of bounds or the wall is on the border
+         */
+        bool open_wall(size_t x, size_t y, Direction dir) { return edit_wall(x, y, dir, false); }
+        bool close_wall(size_t x, size_t y, Direction dir) { return edit_wall(x, y, dir, true); }
+
+        /**
+         * Repair the scores after the edits since the last query and find a shortest path
+         *
+         * @param path filled with the cell indices (y * width + x) from start to end
+         * @return whether a path was found
+         */
+        bool find_path(vector<size_t>& path);
+        /**
+         * Find a shortest path and store it compactly
+         * The path is left empty if there is none
+         */
+        bool find_path(MazePath& path);
+        /**
+         * Repair the scores and return the length of a shortest path in steps,
+         * without walking it
+         *
+         * @return unreachable if there is no path
+         */
+        uint32_t distance();
+
+        // number of cells expanded by the last repair
+        size_t expanded() const { return expanded_cells; }
+};
+
+template <class Maze>
+const uint32_t IncrementalPathSearch<Maze>::unreachable;
+
+#endif
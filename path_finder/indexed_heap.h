@@ -0,0 +1,151 @@
+#ifndef INDEXED_HEAP_H
+#define INDEXED_HEAP_H
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+using std::vector;
+using std::size_t;
+using std::uint32_t;
+
+/**
+ * 4-ary min-heap of 32-bit ids with decrease-key
+ * The heap position of every id is kept in a flat array, so an id can be
+ * found and moved up in O(log n) when its key improves, or moved either way
+ * or removed when its key changes
+ */
+template <class Key>
+class indexed_heap {
+    private:
+        struct entry {
+            Key key;
+            uint32_t id;
+        };
+        vector<entry> heap;
+        vector<uint32_t> positions; // heap position of each id, absent if not in the heap
+
+        void place(size_t position, const entry& value) {
+            heap[position] = value;
+            positions[value.id] = (uint32_t) position;
+        }
+        void sift_up(size_t position) {
+            entry value = heap[position];
+            while (position > 0) {
+                size_t parent = (position - 1) / 4;
+                if (!(value.key < heap[parent].key)) break;
+                place(position, heap[parent]);
+                position = parent;
+            }
+            place(position, value);
+        }
+        void sift_down(size_t position) {
+            entry value = heap[position];
+            size_t size = heap.size();
+            while (true) {
+                size_t first = 4 * position + 1;
+                if (first >= size) break;
+                size_t last = first + 4 < size ? first + 4 : size;
+                size_t smallest = first;
+                for (size_t child = first + 1; child < last; ++child)
+                    if (heap[child].key < heap[smallest].key) smallest = child;
+                if (!(heap[smallest].key < value.key)) break;
+                place(position, heap[smallest]);
+                position = smallest;
+            }
+            place(position, value);
+        }
+    public:
+        static const uint32_t absent = std::numeric_limits<uint32_t>::max();
+
+        indexed_heap() {}
+        /**
+         * @param capacity ids must be less than this
+         */
+        explicit indexed_heap(size_t capacity) : positions(capacity, absent) {}
+
+        /**
+         * Resize for a new id range and empty the heap
+         */
+        void reset(size_t capacity) {
+            heap.clear();
+            positions.assign(capacity, absent);
+        }
+        /**
+         * Empty the heap, touching only the ids still in it
+         */
+        void clear() {
+            for (size_t i = 0; i < heap.size(); ++i) positions[heap[i].id] = absent;
+            heap.clear();
+        }
+        bool empty() const { return heap.empty(); }
+        size_t size() const { return heap.size(); }
+        size_t capacity() const { return positions.size(); }
+        bool contains(uint32_t id) const { return positions[id] != absent; }
+
+        uint32_t top() const { return heap[0].id; }
+        const Key& top_key() const { return heap[0].key; }
+
+        void push(uint32_t id, const Key& key) {
+            heap.push_back(entry());
+            place(heap.size() - 1, entry{key, id});
+            sift_up(heap.size() - 1);
+        }
+        /**
+         * Lower the key of an id already in the heap
+         */
+        void decrease_key(uint32_t id, const Key& key) {
+            size_t position = positions[id];
+            heap[position].key = key;
+            sift_up(position);
+        }
+        /**
+         * Insert an id, or lower its key if it is already in the heap
+         */
+        void push_or_decrease(uint32_t id, const Key& key) {
+            if (contains(id)) decrease_key(id, key);
+            else push(id, key);
+        }
+        /**
+         * Move an id to a new key, higher or lower, or insert it if it is not in the heap
+         */
+        void update(uint32_t id, const Key& key) {
+            if (!contains(id)) {
+                push(id, key);
+                return;
+            }
+            size_t position = positions[id];
+            heap[position].key = key;
+            sift_up(position);
+            sift_down(positions[id]);
+        }
+        /**
+         * Take an id out of the heap wherever it is
+         */
+        void remove(uint32_t id) {
+            size_t position = positions[id];
+            positions[id] = absent;
+            entry last = heap.back();
+            heap.pop_back();
+            if (position < heap.size()) {
+                place(position, last);
+                sift_up(position);
+                sift_down(positions[last.id]);
+            }
+        }
+        void pop() {
+            positions[heap[0].id] = absent;
+            entry last = heap.back();
+            heap.pop_back();
+            if (!heap.empty()) {
+                heap[0] = last;
+                sift_down(0);
+            }
+        }
+};
+
+template <class Key>
+const uint32_t indexed_heap<Key>::absent;
+
+#endif
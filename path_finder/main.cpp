@@ -1,13 +1,28 @@
 #include <iostream>
+#include <fstream>
+#include <chrono>
+#include <queue>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <unordered_map>
 #include "../maze_generator/maze.h"
 #include "path.h"
+#include "distance_field.h"
+#include "tree_index.h"
+#include "corridor_graph.h"
+#include "incremental_search.h"
 
 using std::cout;
+using std::cerr;
+using namespace std::chrono;
 
 void test_random_small() {
     string algorithms[] = { "dfs", "kruskal", "prim", "aldous-broder" };
     for (string alg : algorithms) {
-        auto maze = benchmark_maze(5, 5, alg, true, true, "maze_examples/" + alg + "_maze_small_binary.txt", true);
+        auto maze = generate_maze(5, 5, alg);
+        display_maze(*maze);
+        save_maze(*maze, "maze_examples/" + alg + "_maze_small_binary.txt", true);
         auto start = random_coordinate(5, 5);
         auto end = random_coordinate(5, 5);
         a_star(*maze, start.first, start.second, end.first, end.second);
@@ -19,7 +34,9 @@ void test_random_small() {
 void test_random_large() {
     string algorithms[] = { "dfs", "kruskal", "prim", "aldous-broder" };
     for (string alg : algorithms) {
-        auto maze = benchmark_maze(25, 25, alg, true, true, "maze_examples/" + alg + "_maze_binary.txt", true);
+        auto maze = generate_maze(25, 25, alg);
+        display_maze(*maze);
+        save_maze(*maze, "maze_examples/" + alg + "_maze_binary.txt", true);
         auto start = random_coordinate(25, 25);
         auto end = random_coordinate(25, 25);
         a_star(*maze, start.first, start.second, end.first, end.second);
@@ -31,12 +48,14 @@ void test_random_large() {
 void test_path_small() {
     string small_file = "maze_examples/aldous-broder_maze_small.txt";
     auto small_maze = load_maze(small_file);
+    if (!small_maze) return;
     display_maze(*small_maze);
     a_star(*small_maze, 0, 1, 3, 4);
     display_path(*small_maze, true, true);
 
     string small_bin_file = "maze_examples/aldous-broder_maze_small_binary.txt";
     auto small_bin_maze = load_maze(small_bin_file);
+    if (!small_bin_maze) return;
     display_maze(*small_bin_maze);
     a_star(*small_bin_maze, 0, 0, 4, 4);
     display_path(*small_bin_maze, true, true);
@@ -45,23 +64,518 @@ void test_path_small() {
 void test_path_large() {
     string file = "maze_examples/aldous-broder_maze.txt";
     auto maze = load_maze(file);
+    if (!maze) return;
     a_star(*maze, 0, 0, 24, 24);
     display_path(*maze, true, true);
     
     string bin_file = "maze_examples/aldous-broder_maze_binary.txt";
     auto bin_maze = load_maze(bin_file);
+    if (!bin_maze) return;
     a_star(*bin_maze, 24, 0, 0, 24);
     display_path(*bin_maze, true, true);
 }
 
 void test_load_path() {
     auto maze = load_path("path_examples/aldous-broder_path.txt");
+    if (!maze) return;
     display_path(*maze, true, true);
 }
 
-int main() {
-    // test_small();
-    test_random_small();
-    test_random_large();
-    // test_load_path();
-}
\ No newline at end of file
+void test_compact_path() {
+    auto maze = load_maze("maze_examples/aldous-broder_maze_binary.txt");
+    if (!maze) return;
+    PathSearchContext<MazeGrid> context(*maze);
+    MazePath path;
+    context.find_path(0, 0, 24, 24, path);
+    save_path(path, "path.bin");
+    auto loaded = load_compact_path("path.bin");
+    if (!loaded) return;
+    display_path(*maze, *loaded, true);
+    cout << loaded->size() << " cells in " << loaded->bytes() << " bytes\n";
+}
+
+/**
+ * Check that compact path files with a short or lying header are rejected
+ * instead of allocated or decoded
+ */
+void test_malformed_paths() {
+    string file = "malformed_path.bin";
+    struct malformed_case {
+        const char* name;
+        uint64_t width, start, steps;
+        size_t payload;
+        bool valid;
+    };
+    malformed_case cases[] = {
+        {"valid", 5, 0, 8, 2, true},
+        {"truncated steps", 5, 0, 8, 1, false},
+        {"huge step count", 5, 0, (uint64_t) 1 << 62, 0, false},
+        {"wrapping step count", 5, 0, (uint64_t) -2, 0, false},
+        {"start without width", 0, 3, 0, 0, false},
+    };
+    for (const malformed_case& test : cases) {
+        uint32_t version = 1;
+        uint64_t header[] = {test.width, test.start, test.steps};
+        std::ofstream outfile(file, std::ios::binary);
+        outfile.write("MPTH", 4);
+        outfile.write((const char*) &version, sizeof(version));
+        outfile.write((const char*) header, sizeof(header));
+        outfile << string(test.payload, '\0');
+        outfile.close();
+        bool loaded = load_compact_path(file) != nullptr;
+        cout << "path file " << test.name << ": " << (loaded == test.valid ? "ok" : "FAILED") << "\n";
+    }
+    std::remove(file.c_str());
+}
+
+/**
+ * Previous A*, kept as a baseline for benchmark_a_star
+ * Pushes pointers to 48 byte score structs into a std::priority_queue, changes
+ * their f scores while they are in it, pops the largest f first and keeps
+ * predecessors in an unordered_map
+ */
+bool a_star_reference(const PackedMaze& maze, size_t startX, size_t startY, size_t endX, size_t endY,
+    vector<size_t>& path, size_t& expanded) {
+    struct cell {
+        double g_score, f_score;
+        size_t x, y, index;
+        bool in_queue;
+    };
+    struct f_score_cmp {
+        bool operator()(const cell* a, const cell* b) { return a->f_score < b->f_score; }
+    };
+    auto heuristic = [&](size_t x, size_t y) {
+        return double(std::abs((int)x - (int)endX) + std::abs((int)y - (int)endY));
+    };
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    const int dx[] = {-1, 0, 1, 0}, dy[] = {0, -1, 0, 1}; // offsets for each Direction
+    vector<cell> scores(width*height);
+    for (size_t i = 0; i < width*height; ++i)
+        scores[i] = cell{std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+            i % width, i / width, i, false};
+    std::priority_queue<cell*, vector<cell*>, f_score_cmp> discovered;
+    std::unordered_map<size_t, size_t> predecessors;
+    size_t start = startY * width + startX;
+    scores[start].g_score = 0;
+    scores[start].f_score = heuristic(startX, startY);
+    scores[start].in_queue = true;
+    discovered.push(&scores[start]);
+    path.clear();
+    expanded = 0;
+    while (!discovered.empty()) {
+        cell* current = discovered.top();
+        expanded++;
+        if (current->x == endX && current->y == endY) {
+            for (size_t i = current->index; i != start; i = predecessors[i]) path.push_back(i);
+            path.push_back(start);
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+        current->in_queue = false;
+        discovered.pop();
+        for (int dir = 0; dir < 4; ++dir) {
+            long long nx = (long long) current->x + dx[dir], ny = (long long) current->y + dy[dir];
+            if (nx < 0 || ny < 0 || nx >= (long long) width || ny >= (long long) height
+                || maze.has_wall(current->x, current->y, (Direction) dir)) continue;
+            cell& neighbor = scores[ny * width + nx];
+            if (current->g_score + 1 < neighbor.g_score) {
+                predecessors[neighbor.index] = current->index;
+                neighbor.g_score = current->g_score + 1;
+                neighbor.f_score = neighbor.g_score + heuristic(nx, ny);
+                if (!neighbor.in_queue) {
+                    discovered.push(&neighbor);
+                    neighbor.in_queue = true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Kruskal maze of seed 1 with a fraction of its remaining walls opened, so
+ * that it has loops, drawn from gen
+ */
+unique_ptr<PackedMaze> looped_maze(size_t size, double loops, std::mt19937& gen) {
+    auto maze = generate_packed_maze(size, size, "kruskal", 0, 0, true, 0, 0, 1);
+    if (loops <= 0) return maze;
+    std::bernoulli_distribution open(loops);
+    for (size_t y = 0; y < size; ++y)
+        for (size_t x = 0; x < size; ++x) {
+            if (x + 1 < size && open(gen)) maze->open_wall(x, y, EAST);
+            if (y + 1 < size && open(gen)) maze->open_wall(x, y, SOUTH);
+        }
+    return maze;
+}
+
+/**
+ * Compare expansions, path lengths and latency per query of the previous and
+ * current A* on a perfect maze and on the same maze with extra walls removed
+ * so that it has loops
+ * 
+ * @param loops fraction of the remaining walls to open for the looped maze
+ */
+void benchmark_a_star(size_t size=1024, size_t queries=20, double loops=0.1) {
+    std::mt19937 gen(1);
+    for (int looped = 0; looped < 2; ++looped) {
+        auto maze = looped_maze(size, looped ? loops : 0, gen);
+        std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+        size_t expanded[2] = {0, 0}, lengths[2] = {0, 0};
+        nanoseconds elapsed[2] = {nanoseconds(0), nanoseconds(0)};
+        vector<size_t> path;
+        for (size_t q = 0; q < queries; ++q) {
+            size_t sx = coordinate(gen), sy = coordinate(gen), ex = coordinate(gen), ey = coordinate(gen);
+            size_t count;
+            auto start = high_resolution_clock::now();
+            a_star_reference(*maze, sx, sy, ex, ey, path, count);
+            auto middle = high_resolution_clock::now();
+            expanded[0] += count;
+            lengths[0] += path.size();
+            a_star(*maze, sx, sy, ex, ey, path, "manhattan", &count);
+            auto stop = high_resolution_clock::now();
+            expanded[1] += count;
+            lengths[1] += path.size();
+            elapsed[0] += middle - start;
+            elapsed[1] += stop - middle;
+        }
+        const char* names[] = {"priority_queue", "indexed heap"};
+        cout << "a* " << size << "x" << size << (looped ? " with loops" : " perfect") << ":\n";
+        for (int i = 0; i < 2; ++i)
+            cout << "  " << names[i] << ": " << expanded[i] / queries << " expanded, path "
+                << lengths[i] / queries << " cells, "
+                << duration_cast<microseconds>(elapsed[i]).count() / queries << " us per query\n";
+    }
+}
+
+/**
+ * Compare latency per query of one-shot a_star calls, which set up buffers for
+ * the whole maze every time, against one reused PathSearchContext
+ * Endpoints are at most radius cells apart, as with many short queries
+ */
+void benchmark_search_context(size_t size=2048, size_t queries=2000, size_t radius=16) {
+    std::mt19937 gen(1);
+    auto maze = generate_packed_maze(size, size, "kruskal", 0, 0, true, 0, 0, 1);
+    std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+    std::uniform_int_distribution<int> delta(-(int) radius, (int) radius);
+    auto clamp = [&](size_t value, int offset) {
+        long long moved = (long long) value + offset;
+        return (size_t) std::min(std::max(moved, 0LL), (long long) size - 1);
+    };
+    vector<size_t> endpoints;
+    for (size_t q = 0; q < queries; ++q) {
+        size_t x = coordinate(gen), y = coordinate(gen);
+        endpoints.insert(endpoints.end(), {x, y, clamp(x, delta(gen)), clamp(y, delta(gen))});
+    }
+    vector<size_t> path;
+    size_t expanded = 0;
+    auto start = high_resolution_clock::now();
+    for (size_t q = 0; q < queries; ++q)
+        a_star(*maze, endpoints[4*q], endpoints[4*q+1], endpoints[4*q+2], endpoints[4*q+3], path);
+    auto middle = high_resolution_clock::now();
+    PathSearchContext<PackedMaze> context(*maze);
+    for (size_t q = 0; q < queries; ++q) {
+        context.find_path(endpoints[4*q], endpoints[4*q+1], endpoints[4*q+2], endpoints[4*q+3], path);
+        expanded += context.expanded();
+    }
+    auto stop = high_resolution_clock::now();
+    cout << "a* " << size << "x" << size << ", " << expanded / queries << " expanded per query: one-shot "
+        << duration_cast<microseconds>(middle - start).count() / queries << " us, context "
+        << duration_cast<microseconds>(stop - middle).count() / queries << " us per query\n";
+}
+
+/**
+ * Throughput and p50/p99 latency of batches of random queries on one shared
+ * maze, for 1, 2, 4, ... workers up to the number of hardware threads
+ */
+void benchmark_batch(size_t size=1024, size_t queries=2000) {
+    std::mt19937 gen(1);
+    auto maze = generate_packed_maze(size, size, "kruskal", 0, 0, true, 0, 0, 1);
+    std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+    vector<PathQuery> batch(queries);
+    for (PathQuery& query : batch)
+        query = PathQuery{coordinate(gen), coordinate(gen), coordinate(gen), coordinate(gen)};
+    size_t hardware = resolve_thread_count(0);
+    for (size_t threads = 1; ; threads = std::min(threads * 2, hardware)) {
+        PathQueryEngine<PackedMaze> engine(*maze, threads);
+        vector<PathQueryResult> results;
+        auto start = high_resolution_clock::now();
+        engine.find_paths(batch, results);
+        auto stop = high_resolution_clock::now();
+        vector<uint64_t> latencies;
+        for (const PathQueryResult& result : results) latencies.push_back(result.latency_ns);
+        std::sort(latencies.begin(), latencies.end());
+        double seconds = duration_cast<duration<double>>(stop - start).count();
+        cout << "batch a* " << size << "x" << size << ", " << threads << " threads: "
+            << (size_t) (queries / seconds) << " queries/s, p50 "
+            << latencies[latencies.size() / 2] / 1000 << " us, p99 "
+            << latencies[latencies.size() * 99 / 100] / 1000 << " us\n";
+        if (threads == hardware) break;
+    }
+}
+
+/**
+ * Time distance fields from one source with both frontiers against answering
+ * the same distances with one A* query per target, on a perfect maze and on
+ * the same maze with loops
+ */
+void benchmark_distance_field(size_t size=2048, size_t targets=100, double loops=0.1) {
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+    for (int looped = 0; looped < 2; ++looped) {
+        auto maze = looped_maze(size, looped ? loops : 0, gen);
+        size_t sx = coordinate(gen), sy = coordinate(gen);
+        auto start = high_resolution_clock::now();
+        auto queued = distance_field(*maze, sx, sy, "queue");
+        auto middle = high_resolution_clock::now();
+        auto bitset = distance_field(*maze, sx, sy, "bitset");
+        auto stop = high_resolution_clock::now();
+        PathSearchContext<PackedMaze> context(*maze);
+        vector<size_t> path;
+        size_t mismatches = *queued != *bitset;
+        auto a_star_start = high_resolution_clock::now();
+        for (size_t t = 0; t < targets; ++t) {
+            size_t ex = coordinate(gen), ey = coordinate(gen);
+            context.find_path(sx, sy, ex, ey, path);
+            mismatches += path.size() - 1 != (*queued)[ey * size + ex];
+        }
+        auto a_star_stop = high_resolution_clock::now();
+        cout << "distance field " << size << "x" << size << (looped ? " with loops" : " perfect") << ": queue "
+            << duration_cast<milliseconds>(middle - start).count() << " ms, bitset "
+            << duration_cast<milliseconds>(stop - middle).count() << " ms, " << targets << " a* queries "
+            << duration_cast<milliseconds>(a_star_stop - a_star_start).count() << " ms, "
+            << mismatches << " mismatches\n";
+    }
+}
+
+/**
+ * Time random distance and path queries on the LCA index against A*
+ * Paths and A* are run on a sample of the queries since they take time
+ * proportional to the path length and to the cells expanded
+ */
+void benchmark_tree_index(size_t size=1024, size_t queries=1000000, size_t path_queries=10000,
+    size_t a_star_queries=100) {
+    std::mt19937 gen(1);
+    auto maze = generate_packed_maze(size, size, "kruskal", 0, 0, true, 0, 0, 1);
+    std::uniform_int_distribution<size_t> cell(0, size * size - 1);
+    vector<size_t> endpoints(2 * queries);
+    for (size_t& endpoint : endpoints) endpoint = cell(gen);
+
+    auto build_start = high_resolution_clock::now();
+    auto index = MazeTreeIndex::create(*maze);
+    auto build_stop = high_resolution_clock::now();
+    size_t total = 0;
+    auto start = high_resolution_clock::now();
+    for (size_t q = 0; q < queries; ++q) total += index->distance(endpoints[2*q], endpoints[2*q+1]);
+    auto middle = high_resolution_clock::now();
+    MazePath path;
+    for (size_t q = 0; q < path_queries; ++q) index->path(endpoints[2*q], endpoints[2*q+1], path);
+    auto stop = high_resolution_clock::now();
+
+    PathSearchContext<PackedMaze> context(*maze);
+    size_t mismatches = 0;
+    auto a_star_start = high_resolution_clock::now();
+    for (size_t q = 0; q < a_star_queries; ++q) {
+        size_t a = endpoints[2*q], b = endpoints[2*q+1];
+        context.find_path(a % size, a / size, b % size, b / size, path);
+        mismatches += path.step_count() != index->distance(a, b);
+    }
+    auto a_star_stop = high_resolution_clock::now();
+    cout << "tree index " << size << "x" << size << ": built in "
+        << duration_cast<milliseconds>(build_stop - build_start).count() << " ms, "
+        << (double) index->bytes() / index->cells() << " bytes per cell, mean distance " << total / queries << "\n"
+        << "  " << queries << " distances " << duration_cast<milliseconds>(middle - start).count() << " ms, "
+        << duration_cast<nanoseconds>(middle - start).count() / queries << " ns per query\n"
+        << "  " << path_queries << " paths " << duration_cast<milliseconds>(stop - middle).count() << " ms, "
+        << duration_cast<microseconds>(stop - middle).count() / path_queries << " us per query\n"
+        << "  a* " << duration_cast<microseconds>(a_star_stop - a_star_start).count() / a_star_queries
+        << " us per query over " << a_star_queries << " queries, " << mismatches << " mismatches\n";
+}
+
+/**
+ * Expanded cells and latency per query of every search and heuristic, on a
+ * depth-first search maze with long corridors and a Kruskal maze with short ones
+ */
+void benchmark_search_modes(size_t size=1024, size_t queries=20) {
+    string algorithms[] = { "dfs", "kruskal" };
+    string searches[] = { "a-star", "bidirectional", "corridor" };
+    string heuristics[] = { "manhattan", "euclidean", "none" };
+    for (string algorithm : algorithms) {
+        std::mt19937 gen(1);
+        auto maze = generate_packed_maze(size, size, algorithm, 0, 0, true, 0, 0, 1);
+        std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+        vector<PathQuery> batch(queries);
+        for (PathQuery& query : batch)
+            query = PathQuery{coordinate(gen), coordinate(gen), coordinate(gen), coordinate(gen)};
+        PathSearchContext<PackedMaze> context(*maze);
+        vector<size_t> lengths, path;
+        for (const PathQuery& query : batch) {
+            context.find_path(query.startX, query.startY, query.endX, query.endY, path);
+            lengths.push_back(path.size());
+        }
+        cout << algorithm << " " << size << "x" << size << ":\n";
+        for (string search : searches)
+            for (string heuristic : heuristics) {
+                size_t expanded = 0, mismatches = 0;
+                auto start = high_resolution_clock::now();
+                for (size_t q = 0; q < queries; ++q) {
+                    context.find_path(batch[q].startX, batch[q].startY, batch[q].endX, batch[q].endY,
+                        path, heuristic, search);
+                    expanded += context.expanded();
+                    mismatches += path.size() != lengths[q];
+                }
+                auto stop = high_resolution_clock::now();
+                cout << "  " << search << " " << heuristic << ": " << expanded / queries << " expanded, "
+                    << duration_cast<microseconds>(stop - start).count() / queries << " us per query, "
+                    << mismatches << " mismatches\n";
+            }
+    }
+}
+
+/**
+ * Size of the corridor graph and nodes expanded per query on it against A*
+ * over every cell, on a depth-first search maze and a Kruskal maze
+ */
+void benchmark_corridor_graph(size_t size=2048, size_t queries=20) {
+    string algorithms[] = { "dfs", "kruskal" };
+    for (string algorithm : algorithms) {
+        std::mt19937 gen(1);
+        auto maze = generate_packed_maze(size, size, algorithm, 0, 0, true, 0, 0, 1);
+        std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+        auto build_start = high_resolution_clock::now();
+        CorridorGraph<PackedMaze> graph(*maze);
+        auto build_stop = high_resolution_clock::now();
+        CorridorSearchContext<PackedMaze> graph_search(graph);
+        PathSearchContext<PackedMaze> cell_search(*maze);
+        size_t expanded[2] = {0, 0}, mismatches = 0;
+        nanoseconds elapsed[2] = {nanoseconds(0), nanoseconds(0)};
+        vector<size_t> cell_path, graph_path;
+        for (size_t q = 0; q < queries; ++q) {
+            size_t sx = coordinate(gen), sy = coordinate(gen), ex = coordinate(gen), ey = coordinate(gen);
+            auto start = high_resolution_clock::now();
+            cell_search.find_path(sx, sy, ex, ey, cell_path);
+            auto middle = high_resolution_clock::now();
+            graph_search.find_path(sx, sy, ex, ey, graph_path);
+            auto stop = high_resolution_clock::now();
+            expanded[0] += cell_search.expanded();
+            expanded[1] += graph_search.expanded();
+            elapsed[0] += middle - start;
+            elapsed[1] += stop - middle;
+            mismatches += cell_path.size() != graph_path.size();
+        }
+        cout << "corridor graph " << algorithm << " " << size << "x" << size << ": " << graph.nodes() << " nodes ("
+            << 100.0 * graph.nodes() / (size * size) << "% of cells), " << graph.edges() << " edges, "
+            << graph.bytes() / 1024 << " KiB, built in " << duration_cast<milliseconds>(build_stop - build_start).count()
+            << " ms\n  cells: " << expanded[0] / queries << " expanded, "
+            << duration_cast<microseconds>(elapsed[0]).count() / queries << " us per query\n  graph: "
+            << expanded[1] / queries << " expanded, " << duration_cast<microseconds>(elapsed[1]).count() / queries
+            << " us per query, " << mismatches << " mismatches\n";
+    }
+}
+
+/**
+ * Latency per query of repairing the path with IncrementalPathSearch after
+ * toggling one wall at most radius cells from the goal, against a full A*
+ * on a reused PathSearchContext, on a maze with loops so that most closed
+ * walls leave another way around
+ * Repairs are also reported at the median and 99th percentile, since the few
+ * edits that close the shortest path or cut the goal off cost up to a full
+ * search and dominate the mean.
+ *
+ * @param loops fraction of the remaining walls to open
+ */
+void benchmark_incremental(size_t size=1024, size_t edits=200, size_t radius=8, double loops=0.1) {
+    std::mt19937 gen(1);
+    auto maze = looped_maze(size, loops, gen);
+    std::uniform_int_distribution<size_t> coordinate(0, size - 1);
+    std::uniform_int_distribution<int> delta(-(int) radius, (int) radius);
+    size_t sx = coordinate(gen), sy = coordinate(gen), ex = coordinate(gen), ey = coordinate(gen);
+    IncrementalPathSearch<PackedMaze> incremental(*maze);
+    PathSearchContext<PackedMaze> context(*maze);
+    vector<size_t> path, full_path;
+    incremental.set_endpoints(sx, sy, ex, ey);
+    auto first_start = high_resolution_clock::now();
+    incremental.find_path(path);
+    auto first_stop = high_resolution_clock::now();
+    size_t first_expanded = incremental.expanded();
+
+    size_t expanded[2] = {0, 0}, mismatches = 0;
+    nanoseconds elapsed[3] = {nanoseconds(0), nanoseconds(0), nanoseconds(0)}; // repair, path walk, full a*
+    vector<uint64_t> latencies;
+    for (size_t e = 0; e < edits; ++e) {
+        // a wall east or south of a cell near the goal, opened or closed
+        size_t x = (size_t) std::min(std::max((long long) ex + delta(gen), 0LL), (long long) size - 2);
+        size_t y = (size_t) std::min(std::max((long long) ey + delta(gen), 0LL), (long long) size - 2);
+        Direction dir = gen() % 2 ? EAST : SOUTH;
+        auto start = high_resolution_clock::now();
+        if (maze->has_wall(x, y, dir)) incremental.open_wall(x, y, dir);
+        else incremental.close_wall(x, y, dir);
+        incremental.distance();
+        auto repaired = high_resolution_clock::now();
+        expanded[0] += incremental.expanded();
+        incremental.find_path(path); // nothing left to repair, so this only walks the path
+        auto middle = high_resolution_clock::now();
+        context.find_path(sx, sy, ex, ey, full_path);
+        auto stop = high_resolution_clock::now();
+        expanded[1] += context.expanded();
+        elapsed[0] += repaired - start;
+        elapsed[1] += middle - repaired;
+        elapsed[2] += stop - middle;
+        latencies.push_back(duration_cast<nanoseconds>(repaired - start).count());
+        mismatches += path.size() != full_path.size();
+    }
+    std::sort(latencies.begin(), latencies.end());
+    cout << "incremental " << size << "x" << size << ", edits within " << radius << " cells of the goal: first search "
+        << first_expanded << " expanded, " << duration_cast<microseconds>(first_stop - first_start).count() << " us\n"
+        << "  repair: " << expanded[0] / edits << " expanded, "
+        << duration_cast<microseconds>(elapsed[0]).count() / edits << " us per edit, p50 "
+        << latencies[latencies.size() / 2] / 1000.0 << " us, p99 " << latencies[latencies.size() * 99 / 100] / 1000
+        << " us\n"
+        << "  path walk: " << duration_cast<microseconds>(elapsed[1]).count() / edits << " us per edit\n"
+        << "  full a*: " << expanded[1] / edits << " expanded, "
+        << duration_cast<microseconds>(elapsed[2]).count() / edits << " us per edit, " << mismatches << " mismatches\n";
+}
+
+/**
+ * Checks and benchmarks run by name from the command line instead of the
+ * default tests, e.g. ./path a-star incremental
+ */
+struct named_run {
+    const char* name;
+    void (*run)();
+};
+
+static const named_run runs[] = {
+    {"compact-path", [] { test_compact_path(); }},
+    {"a-star", [] { benchmark_a_star(); }},
+    {"search-context", [] { benchmark_search_context(); }},
+    {"batch", [] { benchmark_batch(); }},
+    {"distance-field", [] { benchmark_distance_field(); }},
+    {"tree-index", [] { benchmark_tree_index(); }},
+    {"search-modes", [] { benchmark_search_modes(); }},
+    {"corridor-graph", [] { benchmark_corridor_graph(); }},
+    {"incremental", [] { benchmark_incremental(); }},
+};
+
+int main(int argc, char* argv[]) {
+    if (argc == 1) {
+        // test_small();
+        test_random_small();
+        test_random_large();
+        test_malformed_paths();
+        // test_load_path();
+        return 0;
+    }
+    vector<const named_run*> selected;
+    for (int i = 1; i < argc; ++i) {
+        for (const named_run& run : runs)
+            if (string(argv[i]) == run.name) selected.push_back(&run);
+        if (selected.size() == (size_t) i - 1) {
+            cerr << "ERROR: unknown run " << argv[i] << ", expected one of:";
+            for (const named_run& run : runs) cerr << " " << run.name;
+            cerr << "\n";
+            return 1;
+        }
+    }
+    for (const named_run* run : selected) run->run();
+    return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef MAZE_PATH_H
+#define MAZE_PATH_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "../maze_generator/maze_grid.h"
+
+using std::vector;
+using std::size_t;
+using std::uint8_t;
+
+/**
+ * Path through a maze stored apart from the maze itself
+ * Kept as the start cell followed by one 2-bit Direction per step, 4 steps to
+ * a byte, so a path of n cells takes about n/4 bytes. Cell indices are
+ * y * width + x, with width the number of cells in a row of the maze.
+ */
+class MazePath {
+    private:
+        size_t maze_width;
+        size_t start_cell;
+        size_t end_cell;
+        size_t steps;
+        vector<uint8_t> moves;
+
+        static ptrdiff_t cell_offset(Direction dir, size_t width) {
+            switch (dir) {
+                case WEST: return -1;
+                case NORTH: return -(ptrdiff_t) width;
+                case EAST: return 1;
+                default: return (ptrdiff_t) width;
+            }
+        }
+    public:
+        MazePath() : maze_width(0), start_cell(0), end_cell(0), steps(0) {}
+        /**
+         * Path of a single cell
+         *
+         * @param width number of cells in a row of the maze
+         * @param start index of the first cell
+         */
+        MazePath(size_t width, size_t start) {
+            assign(width, start);
+        }
+        /**
+         * Encode a path given as consecutive neighboring cell indices
+         * Empty if two consecutive cells are not neighbors
+         */
+        MazePath(const vector<size_t>& cells, size_t width) {
+            assign(cells, width);
+        }
+
+        void assign(size_t width, size_t start) {
+            maze_width = width, start_cell = start, end_cell = start, steps = 0;
+            moves.clear();
+        }
+        /**
+         * @return false if two consecutive cells are not neighbors, leaving the path empty
+         */
+        bool assign(const vector<size_t>& cells, size_t width) {
+            if (cells.empty()) {
+                *this = MazePath();
+                return true;
+            }
+            assign(width, cells[0]);
+            moves.reserve(cells.size() / 4 + 1);
+            for (size_t i = 1; i < cells.size(); ++i) {
+                size_t previous = cells[i-1], cell = cells[i];
+                // north and south first, so that a one cell wide maze is not read as west and east
+                if (cell + width == previous) push(NORTH);
+                else if (previous + width == cell) push(SOUTH);
+                else if (cell + 1 == previous && previous % width != 0) push(WEST);
+                else if (previous + 1 == cell && cell % width != 0) push(EAST);
+                else {
+                    *this = MazePath();
+                    return false;
+                }
+            }
+            return true;
+        }
+        /**
+         * Decode from the packed form, as read back from a file
+         *
+         * @param data (count+3)/4 bytes of packed directions
+         */
+        void assign(size_t width, size_t start, size_t count, const uint8_t* data) {
+            assign(width, start);
+            moves.assign(data, data + (count + 3) / 4);
+            steps = count;
+            for (size_t i = 0; i < steps; ++i) end_cell += cell_offset(step(i), width);
+        }
+
+        /**
+         * Extend the path by one cell
+         */
+        void push(Direction dir) {
+            if (steps % 4 == 0) moves.push_back(0);
+            moves.back() |= (uint8_t) (dir << ((steps % 4) * 2));
+            end_cell += cell_offset(dir, maze_width);
+            steps++;
+        }
+
+        // no path, not even a start cell
+        bool empty() const { return maze_width == 0; }
+        // number of cells on the path, including start and end
+        size_t size() const { return empty() ? 0 : steps + 1; }
+        size_t step_count() const { return steps; }
+        size_t width() const { return maze_width; }
+        size_t start() const { return start_cell; }
+        size_t end() const { return end_cell; }
+        // bytes used by the packed directions
+        size_t bytes() const { return moves.size(); }
+        const uint8_t* data() const { return moves.data(); }
+
+        /**
+         * Direction of the i-th step
+         */
+        Direction step(size_t i) const {
+            return (Direction) ((moves[i >> 2] >> ((i & 3) * 2)) & 3);
+        }
+        /**
+         * Decode to the cell indices from start to end
+         */
+        vector<size_t> cells() const {
+            vector<size_t> decoded;
+            if (empty()) return decoded;
+            decoded.reserve(steps + 1);
+            decoded.push_back(start_cell);
+            for (size_t i = 0; i < steps; ++i)
+                decoded.push_back(decoded.back() + cell_offset(step(i), maze_width));
+            return decoded;
+        }
+};
+
+#endif
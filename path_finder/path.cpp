@@ -2,16 +2,18 @@
 #include <fstream>
 #include <cmath>
 #include <limits>
-#include <queue>
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include "path.h"
+#include "../maze_generator/mapped_file.h"
 
 using std::cout;
 using std::cerr;
 using std::pair;
 using std::make_pair;
-using std::priority_queue;
-using std::unordered_map;
+using std::uint64_t;
 
 /**
  * Print maze and path to stdout
@@ -19,69 +21,200 @@ using std::unordered_map;
  * @param colors enable colors for terminals that support it
  * @param visited indicate visited cells even if they are not on the path
  */ 
-void display_path(vector<vector<int>>& grid, bool colors, bool visited) {
-    unordered_map<int, string> blocks = {
-        {0, "  "},
-        {1, "██"},
-        {2, "◀▶"},
-        {3, "SS"},
-        {4, "EE"},
-        {5, "  "}};
-    if (visited) {
-        if (colors) blocks[5] = "\033[1;34m██\033[0m";
-        else blocks[5] = "..";
+void display_path(const MazeGrid& grid, bool colors, bool visited) {
+    terminal_renderer(colors, visited).draw(grid);
+}
+
+/**
+ * Print a maze with a path drawn over it, leaving the maze unchanged
+ * The path slots are sorted by position and merged into each row as it is printed
+ */
+template <class Maze>
+static void display_path_overlay(const Maze& maze, const MazePath& path, bool colors) {
+    size_t grid_width = 2 * maze.cell_width() + 1, grid_height = 2 * maze.cell_height() + 1;
+    if (!path.empty() && path.width() != maze.cell_width()) {
+        cerr << "ERROR: path does not belong to this maze!\n";
+        return;
     }
-    if (colors) {
-        blocks[2] = "\033[1;35m██\033[0m";
-        blocks[3] = "\033[1;31m██\033[0m";
-        blocks[4] = "\033[1;32m██\033[0m";
+    vector<pair<size_t, uint8_t>> marks; // (flat grid index, slot value) of every path slot
+    vector<size_t> cells = path.cells();
+    for (size_t i = 0; i < cells.size(); ++i) {
+        size_t gridX = 2 * (cells[i] % path.width()) + 1, gridY = 2 * (cells[i] / path.width()) + 1;
+        if (i > 0) { // the wall slot between this cell and the previous one
+            size_t prevX = 2 * (cells[i-1] % path.width()) + 1, prevY = 2 * (cells[i-1] / path.width()) + 1;
+            marks.push_back(make_pair((gridY + prevY) / 2 * grid_width + (gridX + prevX) / 2, 2));
+        }
+        marks.push_back(make_pair(gridY * grid_width + gridX, 2));
+    }
+    if (!cells.empty()) {
+        marks.front().second = 3;
+        marks.back().second = 4;
     }
-    for (size_t j = 0; j < grid[0].size(); ++j) {
-        for (size_t i = 0; i < grid.size(); ++i)
-            cout << blocks[grid[i][j]];
-        cout << "\n";
+    std::stable_sort(marks.begin(), marks.end(),
+        [](const pair<size_t, uint8_t>& a, const pair<size_t, uint8_t>& b) { return a.first < b.first; });
+
+    terminal_renderer renderer(colors);
+    vector<uint8_t> buffer(grid_width), row(grid_width);
+    size_t next = 0;
+    renderer.begin_frame(grid_width, grid_height);
+    for (size_t j = 0; j < grid_height; ++j) {
+        const uint8_t* slots = grid_row(maze, j, buffer.data());
+        std::copy(slots, slots + grid_width, row.begin());
+        for (; next < marks.size() && marks[next].first < (j + 1) * grid_width; ++next)
+            row[marks[next].first - j * grid_width] = marks[next].second;
+        renderer.add_row(row.data());
     }
+    renderer.end_frame();
+}
+
+void display_path(const MazeGrid& grid, const MazePath& path, bool colors) {
+    display_path_overlay(grid, path, colors);
+}
+
+void display_path(const PackedMaze& maze, const MazePath& path, bool colors) {
+    display_path_overlay(maze, path, colors);
+}
+
+void display_path(vector<vector<int>>& grid, bool colors, bool visited) {
+    display_path(MazeGrid(grid), colors, visited);
 }
 
 /**
  * Save maze with path to a file
  */ 
-void save_path(vector<vector<int>>& grid, string file_path) {
+void save_path(const MazeGrid& grid, string file_path) {
     std::ofstream outfile(file_path);
     if (!outfile.is_open()) {
         cerr << "ERROR: unable to open file!\n";
         exit(1);
     }
-    for (size_t j = 0; j < grid[0].size(); ++j) {
-        for (size_t i = 0; i < grid.size(); ++i) {
-            outfile << std::to_string(grid[i][j]);
+    for (size_t j = 0; j < grid.height(); ++j) {
+        const uint8_t* row = grid.row(j);
+        for (size_t i = 0; i < grid.width(); ++i) {
+            outfile << std::to_string(row[i]);
         }
         outfile << "\n";
     }
 }
 
+void save_path(vector<vector<int>>& grid, string file_path) {
+    save_path(MazeGrid(grid), file_path);
+}
+
 /**
  * Open a saved maze and path from a file
+ * The file is mapped and each line is converted straight into its row of the grid
+ *
+ * @return empty if the file cannot be opened or is malformed, with the line
+ *         and column of the problem
  */ 
-unique_ptr<vector<vector<int>>> load_path(string file_path) {
-    std::ifstream infile(file_path);
-    if (!infile.is_open()) {
+unique_ptr<MazeGrid> load_path(string file_path) {
+    mapped_file file(file_path);
+    if (!file.is_open()) {
         cerr << "ERROR: unable to open file!\n";
-        exit(1);
+        return unique_ptr<MazeGrid>();
     }
-    string line;
-    bool is_first = true;
-    vector<vector<int>>* grid = new vector<vector<int>>();
-    while (std::getline(infile, line)) {
-        size_t row = 0;
-        for (char cell : line) {
-            if (is_first) grid->push_back(vector<int>());
-            (*grid)[row].push_back(cell - '0');
-            row++;
+    const char *data = file.data(), *end = data + file.size();
+    size_t height = 0, width = 0;
+    for (const char* p = data; p < end; ++height) {
+        const char* newline = (const char*) std::memchr(p, '\n', end - p);
+        if (height == 0) width = (size_t) ((newline ? newline : end) - p);
+        p = newline ? newline + 1 : end;
+    }
+    if (width > 0 && data[width - 1] == '\r') width--;
+    unique_ptr<MazeGrid> grid{new MazeGrid(width, height)};
+    const char* line = data;
+    for (size_t j = 0; j < height; ++j) {
+        const char* newline = (const char*) std::memchr(line, '\n', end - line);
+        size_t length = (size_t) ((newline ? newline : end) - line);
+        if (length > 0 && line[length - 1] == '\r') length--;
+        if (length != width) {
+            cerr << "ERROR: " << file_path << ":" << j + 1 << ":" << std::min(length, width) + 1 
+                << ": row does not have " << width << " slots\n";
+            return unique_ptr<MazeGrid>();
+        }
+        uint8_t* slots = grid->row(j);
+        uint8_t bad = 0;
+        for (size_t i = 0; i < length; ++i) { // no branches, so this is vectorized
+            uint8_t slot = (uint8_t) (line[i] - '0');
+            slots[i] = slot;
+            bad |= (uint8_t) (slot > 5);
         }
-        if (is_first) is_first = false;
+        if (bad) {
+            size_t column = 1;
+            while ((uint8_t) (line[column - 1] - '0') <= 5) ++column;
+            cerr << "ERROR: " << file_path << ":" << j + 1 << ":" << column << ": expected a slot from 0 to 5\n";
+            return unique_ptr<MazeGrid>();
+        }
+        line = newline ? newline + 1 : end;
+    }
+    return grid;
+}
+
+static const char path_file_magic[4] = {'M', 'P', 'T', 'H'};
+static const uint32_t path_file_version = 1;
+
+/**
+ * Save a compact path in binary
+ * Layout: "MPTH", uint32 version, uint64 maze width, start cell and step
+ * count in host byte order, then the packed 2-bit directions
+ */
+void save_path(const MazePath& path, string file_path) {
+    std::ofstream outfile(file_path, std::ios::binary);
+    if (!outfile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        exit(1);
     }
-    return unique_ptr<vector<vector<int>>>{grid};
+    uint64_t header[] = {path.width(), path.start(), path.step_count()};
+    outfile.write(path_file_magic, sizeof(path_file_magic));
+    outfile.write((const char*) &path_file_version, sizeof(path_file_version));
+    outfile.write((const char*) header, sizeof(header));
+    outfile.write((const char*) path.data(), path.bytes());
+}
+
+/**
+ * Open a compact path saved by save_path
+ * The step count is checked against the file size before anything is
+ * allocated for it
+ *
+ * @return empty if the file cannot be opened or is malformed
+ */
+unique_ptr<MazePath> load_compact_path(string file_path) {
+    std::ifstream infile(file_path, std::ios::binary | std::ios::ate);
+    if (!infile.is_open()) {
+        cerr << "ERROR: unable to open file!\n";
+        return unique_ptr<MazePath>();
+    }
+    uint64_t file_size = (uint64_t) infile.tellg();
+    infile.seekg(0);
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t header[3];
+    infile.read(magic, sizeof(magic));
+    infile.read((char*) &version, sizeof(version));
+    infile.read((char*) header, sizeof(header));
+    if (!infile || !std::equal(magic, magic + 4, path_file_magic) || version != path_file_version) {
+        cerr << "ERROR: " << file_path << " is not a compact path file!\n";
+        return unique_ptr<MazePath>();
+    }
+    if (header[0] == 0 && (header[1] != 0 || header[2] != 0)) { // an empty path has no width
+        cerr << "ERROR: " << file_path << " has a start or steps without a maze width!\n";
+        return unique_ptr<MazePath>();
+    }
+    uint64_t payload = file_size - (uint64_t) infile.tellg();
+    if (header[2] > (uint64_t) -1 - 3 || (header[2] + 3) / 4 > payload) {
+        cerr << "ERROR: " << file_path << " is truncated!\n";
+        return unique_ptr<MazePath>();
+    }
+    vector<uint8_t> moves((size_t) ((header[2] + 3) / 4));
+    infile.read((char*) moves.data(), moves.size());
+    if (!infile) {
+        cerr << "ERROR: " << file_path << " is truncated!\n";
+        return unique_ptr<MazePath>();
+    }
+    MazePath* path = new MazePath();
+    if (header[0] > 0) path->assign(header[0], header[1], header[2], moves.data());
+    return unique_ptr<MazePath>{path};
 }
 
 size_t flatten_coordinate(size_t width, size_t x, size_t y) {
@@ -95,128 +228,383 @@ pair<size_t, size_t> restore_coordinate(size_t width, size_t flattened_coord) {
 }
 
 double a_star_heuristic(size_t x, size_t y, size_t goalX, size_t goalY, int heuristic) {
-    // manhattan distance
-    if (heuristic == 0) 
-        return double(std::abs((int)x - (int)goalX) + std::abs((int)y - (int)goalY));
-    else return 0;
-}
-
-struct a_star_cell {
-    double g_score;
-    double f_score;
-    size_t x;
-    size_t y;
-    size_t index;
-    bool in_queue; // true if in priority queue
-    // for the start point
-    a_star_cell() : g_score(std::numeric_limits<double>::max()), 
-        f_score(std::numeric_limits<double>::max()), x(0), y(0), index(0), in_queue(false) {}
-    a_star_cell(size_t x, size_t y, size_t endX, size_t endY, size_t width, int heuristic) 
-        : g_score(0), f_score(a_star_heuristic(x, y, endX, endY, heuristic)), 
-        x(x), y(y), index(flatten_coordinate(width, x, y)), in_queue(true) {}
-    // for other points
-    a_star_cell(size_t index, size_t width) : g_score(std::numeric_limits<double>::max()), 
-        f_score(std::numeric_limits<double>::max()), index(index), in_queue(false) {
-        auto coords = restore_coordinate(width, index);
-        x = coords.first, y = coords.second;
-    }
-};
-
-struct f_score_cmp {
-    bool operator()(const a_star_cell* a, const a_star_cell* b) {
-        return a->f_score < b->f_score;
-    }
-};
+    double dx = std::abs((double) x - (double) goalX), dy = std::abs((double) y - (double) goalY);
+    if (heuristic == 0) return dx + dy; // manhattan distance
+    else if (heuristic == 1) return std::sqrt(dx * dx + dy * dy); // euclidean distance
+    else return 0; // none, plain breadth-first order
+}
 
-/**
- * Solves maze using A* algorithm
- * Coordinates are wrt the number of cells (input to generate_maze)
- * 
- * @param heuristic heuristic to use (manhattan, euclidean)
- */ 
-bool a_star(vector<vector<int>>& grid, size_t startX, size_t startY, size_t endX, size_t endY,
-    string heuristic, bool track_visited) {
-    // determine heuristic to use
-    int heuristic_index = 0;
-    if (heuristic == "euclidean") heuristic_index = 1;
+int parse_heuristic(string heuristic) {
+    if (heuristic == "euclidean") return 1;
+    else if (heuristic == "none") return 2;
     else if (heuristic != "manhattan") cerr << "ERROR: Invalid A* heuristic!\n";
+    return 0;
+}
 
-    size_t width = (grid.size()-1)/2, height = (grid[0].size()-1)/2;
-    int neighbor_offsets[] = {-1, -1 * (int) width, +1, (int) width}; // index offsets
-    pair<int, int> neighbor_grid_offsets[] = {{-1, 0}, {0, -1}, {1, 0}, {0, 1}}; // grid offsets / 2
-    double wall_weight = 1;
+template <class Maze>
+PathSearchContext<Maze>::PathSearchContext(const Maze& maze)
+    : maze(nullptr), width(0), height(0), epoch(0), expanded_cells(0) {
+    bind(maze);
+}
 
-    // Coordinates will be referenced with 1D indices
-    vector<a_star_cell> scores; // tracks g and f scores
-    scores.reserve(width*height);
-    for (size_t i = 0; i < width*height; ++i) scores.push_back(a_star_cell(i, width));
+template <class Maze>
+void PathSearchContext<Maze>::bind(const Maze& maze) {
+    this->maze = &maze;
+    width = maze.cell_width(), height = maze.cell_height();
+    if (width * height > epochs.size()) {
+        epochs.assign(width * height, 0);
+        g_scores.resize(width * height);
+        predecessors.resize(width * height);
+        discovered.reset(width * height);
+        // the other searches allocate their buffers on first use
+        backward_epochs.clear();
+        jump_directions.clear();
+        epoch = 0;
+    }
+}
 
-    // tracks set of discovered cells, ordered by f_score
-    priority_queue<a_star_cell*, vector<a_star_cell*>, f_score_cmp> discovered;
-    unordered_map<size_t, size_t> predecessors; // tracks preceding cell of each cell
+template <class Maze>
+void PathSearchContext<Maze>::next_epoch() {
+    discovered.clear();
+    backward_discovered.clear();
+    if (++epoch == 0) {
+        // the counter wrapped, so old epochs could collide with new ones
+        std::fill(epochs.begin(), epochs.end(), 0);
+        std::fill(backward_epochs.begin(), backward_epochs.end(), 0);
+        epoch = 1;
+    }
+}
+
+/**
+ * Reads walls through the cell interface shared by MazeGrid and PackedMaze so
+ * neither has to be converted to the other
+ * Cells are 32-bit indices into flat epoch, g score and predecessor arrays, and
+ * the open sets are indexed 4-ary min-heaps so improved cells are moved with
+ * decrease-key instead of being pushed again
+ */
+template <class Maze>
+bool PathSearchContext<Maze>::find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+    vector<size_t>& path, string heuristic, string search) {
+    path.clear();
+    expanded_cells = 0;
+    if (width * height >= (size_t) indexed_heap<key>::absent) {
+        cerr << "ERROR: maze is too large for 32-bit cell indices!\n";
+        return false;
+    }
+    if (startX >= width || startY >= height || endX >= width || endY >= height) {
+        cerr << "ERROR: A* coordinates out of bounds!\n";
+        return false;
+    }
+    int heuristic_index = parse_heuristic(heuristic);
+    uint32_t start = (uint32_t) flatten_coordinate(width, startX, startY);
+    uint32_t end = (uint32_t) flatten_coordinate(width, endX, endY);
+    next_epoch();
+    bool found;
+    if (search == "bidirectional") found = search_bidirectional(start, end, heuristic_index, path);
+    else if (search == "corridor") found = search_corridors(start, end, heuristic_index, path);
+    else {
+        if (search != "a-star") cerr << "ERROR: Invalid path search!\n";
+        found = search_forward(start, end, heuristic_index, path);
+    }
+    if (!found) cerr << "No path found!\n";
+    return found;
+}
 
-    // handle starting point
-    size_t start = flatten_coordinate(width, startX, startY);
-    scores[start] = a_star_cell(startX, startY, endX, endY, width, heuristic_index);
-    discovered.push(&(scores[start]));
+template <class Maze>
+bool PathSearchContext<Maze>::search_forward(uint32_t start, uint32_t end, int heuristic, vector<size_t>& path) {
+    size_t endX = end % width, endY = end / width;
+    ptrdiff_t neighbor_offsets[] = {-1, -(ptrdiff_t) width, 1, (ptrdiff_t) width}; // index offsets
+    epochs[start] = epoch;
+    g_scores[start] = 0;
+    predecessors[start] = start;
+    discovered.push(start, key{a_star_heuristic(start % width, start / width, endX, endY, heuristic), 0});
 
     while (!discovered.empty()) {
-        auto current_cell = discovered.top();
-        // if reached end, reconstruct path
-        if (current_cell->x == endX && current_cell->y == endY) {
-            int gridX = (int) 2*endX+1, gridY = (int) 2*endY+1;
-            grid[gridX][gridY] = 3;
-            size_t current = current_cell->index;
-            // backtrack through predecessors
-            while (current != start) {
-                gridX = (int) 2*scores[current].x+1;
-                gridY = (int) 2*scores[current].y+1;
-                size_t predecessor = predecessors[current];
-                int wallX = (int) scores[predecessor].x - (int) scores[current].x;
-                int wallY = (int) scores[predecessor].y - (int) scores[current].y;
-                grid[gridX][gridY] = 2;
-                grid[gridX + wallX][gridY + wallY] = 2;
-                current = predecessor;
-            }
-            grid[2*startX+1][2*startY+1] = 3;
-            grid[2*endX+1][2*endY+1] = 4;
+        uint32_t current = discovered.top();
+        discovered.pop();
+        expanded_cells++;
+        // if reached end, reconstruct path by backtracking through predecessors
+        if (current == end) {
+            for (; current != start; current = predecessors[current]) path.push_back(current);
+            path.push_back(start);
+            std::reverse(path.begin(), path.end());
             return true;
         }
-        // if (track_visited) grid[2*current_cell->x+1][2*current_cell->y+1] = 5;
-        current_cell->in_queue = false;
-        discovered.pop();
-        for (size_t i = 0; i < 4; ++i) {
-            // index offset between current and neighbor
-            int offset = (int) current_cell->index + neighbor_offsets[i];
-            // grid coords of wall between current and neighbor
-            int wallX = 2* (int) current_cell->x + 1 + neighbor_grid_offsets[i].first;
-            int wallY = 2* (int) current_cell->y + 1 + neighbor_grid_offsets[i].second;
-            // grid coords of neighbor
-            int gridX = 2* ((int) current_cell->x + neighbor_grid_offsets[i].first) + 1;
-            int gridY = 2* ((int) current_cell->y + neighbor_grid_offsets[i].second) + 1;
+        size_t x = current % width, y = current / width;
+        uint32_t new_g_score = g_scores[current] + 1;
+        for (int i = 0; i < 4; ++i) {
             // check that neighbor exists and there is an open path
-            if (gridX > 0 && gridX < 2 * (int) width && gridY > 0 && gridY < 2 * (int) height
-                && grid[wallX][wallY] != 1) {
-                double new_g_score = current_cell->g_score + wall_weight;
-                if (new_g_score < scores[offset].g_score) {
-                    // mark visited neighbors and walls if applicable
-                    if (track_visited) {
-                        grid[wallX][wallY] = 5;
-                        grid[gridX][gridY] = 5;
-                    }
-                    // if neighbor has better score, move there
-                    predecessors[offset] = current_cell->index;
-                    scores[offset].g_score = new_g_score;
-                    scores[offset].f_score = new_g_score + a_star_heuristic(scores[offset].x,
-                        scores[offset].y, endX, endY, heuristic_index);
-                    if (!scores[offset].in_queue) {
-                        discovered.push(&(scores[offset]));
-                        scores[offset].in_queue = true;
-                    }
+            if (!has_opening(*maze, x, y, (Direction) i)) continue;
+            uint32_t neighbor = (uint32_t) (current + neighbor_offsets[i]);
+            // if neighbor has better score, move there
+            if (!reached(neighbor) || new_g_score < g_scores[neighbor]) {
+                epochs[neighbor] = epoch;
+                predecessors[neighbor] = current;
+                g_scores[neighbor] = new_g_score;
+                double f_score = new_g_score + a_star_heuristic(neighbor % width, neighbor / width,
+                    endX, endY, heuristic);
+                discovered.push_or_decrease(neighbor, key{f_score, new_g_score});
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * A* from both ends at once, expanding the side with the smaller open set
+ * Every cell reached from both sides is a candidate meeting point. The search
+ * stops once the smallest f score of either open set is no better than the
+ * best meeting so far, since f is a lower bound on any path still unfound.
+ * With the "none" heuristic this is a bidirectional breadth-first search,
+ * which can stop as soon as the two smallest distances add up to the best meeting.
+ */
+template <class Maze>
+bool PathSearchContext<Maze>::search_bidirectional(uint32_t start, uint32_t end, int heuristic,
+    vector<size_t>& path) {
+    struct side {
+        vector<uint32_t>& epochs;
+        vector<uint32_t>& g_scores;
+        vector<uint32_t>& predecessors;
+        indexed_heap<key>& open;
+        size_t goalX, goalY;
+    };
+    if (backward_epochs.size() < width * height) {
+        backward_epochs.assign(width * height, 0);
+        backward_g_scores.resize(width * height);
+        backward_predecessors.resize(width * height);
+        backward_discovered.reset(width * height);
+    }
+    side sides[2] = {
+        {epochs, g_scores, predecessors, discovered, end % width, end / width},
+        {backward_epochs, backward_g_scores, backward_predecessors, backward_discovered, start % width, start / width}};
+    uint32_t roots[2] = {start, end};
+    for (int s = 0; s < 2; ++s) {
+        sides[s].epochs[roots[s]] = epoch;
+        sides[s].g_scores[roots[s]] = 0;
+        sides[s].predecessors[roots[s]] = roots[s];
+        sides[s].open.push(roots[s], key{a_star_heuristic(roots[s] % width, roots[s] / width,
+            sides[s].goalX, sides[s].goalY, heuristic), 0});
+    }
+    ptrdiff_t neighbor_offsets[] = {-1, -(ptrdiff_t) width, 1, (ptrdiff_t) width}; // index offsets
+    uint32_t best = start == end ? 0 : indexed_heap<key>::absent, meeting = start;
+
+    while (!discovered.empty() && !backward_discovered.empty()) {
+        double forward_f = discovered.top_key().f_score, backward_f = backward_discovered.top_key().f_score;
+        if (forward_f >= best || backward_f >= best) break;
+        // without a heuristic f is the distance, so the two frontiers bound any unfound path together
+        if (heuristic == 2 && forward_f + backward_f >= best) break;
+        int s = discovered.size() <= backward_discovered.size() ? 0 : 1;
+        side& self = sides[s];
+        side& other = sides[1 - s];
+        uint32_t current = self.open.top();
+        self.open.pop();
+        expanded_cells++;
+        size_t x = current % width, y = current / width;
+        uint32_t new_g_score = self.g_scores[current] + 1;
+        for (int i = 0; i < 4; ++i) {
+            if (!has_opening(*maze, x, y, (Direction) i)) continue;
+            uint32_t neighbor = (uint32_t) (current + neighbor_offsets[i]);
+            if (self.epochs[neighbor] == epoch && new_g_score >= self.g_scores[neighbor]) continue;
+            self.epochs[neighbor] = epoch;
+            self.predecessors[neighbor] = current;
+            self.g_scores[neighbor] = new_g_score;
+            double f_score = new_g_score + a_star_heuristic(neighbor % width, neighbor / width,
+                self.goalX, self.goalY, heuristic);
+            self.open.push_or_decrease(neighbor, key{f_score, new_g_score});
+            if (other.epochs[neighbor] == epoch && new_g_score + other.g_scores[neighbor] < best) {
+                best = new_g_score + other.g_scores[neighbor];
+                meeting = neighbor;
+            }
+        }
+    }
+    if (best == indexed_heap<key>::absent) return false;
+    for (uint32_t current = meeting; current != start; current = predecessors[current]) path.push_back(current);
+    path.push_back(start);
+    std::reverse(path.begin(), path.end());
+    for (uint32_t current = meeting; current != end; ) {
+        current = backward_predecessors[current];
+        path.push_back(current);
+    }
+    return true;
+}
+
+/**
+ * A* over the junctions of the maze only
+ * From each expanded cell, every open direction is followed along the
+ * corridor while cells have exactly two openings, and the cell where the
+ * corridor ends is relaxed with the whole corridor length in one step. The
+ * start and end cells always stop a corridor. Jumped-over cells are not
+ * expanded or scored; the path is walked again through the corridors from the
+ * direction each jump left its predecessor in.
+ */
+template <class Maze>
+bool PathSearchContext<Maze>::search_corridors(uint32_t start, uint32_t end, int heuristic, vector<size_t>& path) {
+    if (jump_directions.size() < width * height) jump_directions.resize(width * height);
+    size_t endX = end % width, endY = end / width;
+    ptrdiff_t neighbor_offsets[] = {-1, -(ptrdiff_t) width, 1, (ptrdiff_t) width}; // index offsets
+    // next cell along a corridor entered through the side opposite to dir, or the cell itself if it stops there
+    auto follow = [&](uint32_t cell, Direction& dir) {
+        if (cell == start || cell == end) return cell;
+        return (uint32_t) corridor_step(*maze, cell, dir);
+    };
+    epochs[start] = epoch;
+    g_scores[start] = 0;
+    predecessors[start] = start;
+    discovered.push(start, key{a_star_heuristic(start % width, start / width, endX, endY, heuristic), 0});
+
+    while (!discovered.empty()) {
+        uint32_t current = discovered.top();
+        discovered.pop();
+        expanded_cells++;
+        if (current == end) {
+            vector<uint32_t> junctions;
+            for (; current != start; current = predecessors[current]) junctions.push_back(current);
+            path.push_back(start);
+            for (size_t j = junctions.size(); j-- > 0; ) {
+                Direction dir = (Direction) jump_directions[junctions[j]];
+                uint32_t cell = (uint32_t) (path.back() + neighbor_offsets[dir]);
+                path.push_back(cell);
+                while (cell != junctions[j]) {
+                    cell = follow(cell, dir);
+                    path.push_back(cell);
                 }
             }
-        }    
+            return true;
+        }
+        size_t x = current % width, y = current / width;
+        for (int i = 0; i < 4; ++i) {
+            if (!has_opening(*maze, x, y, (Direction) i)) continue;
+            Direction dir = (Direction) i;
+            uint32_t cell = (uint32_t) (current + neighbor_offsets[i]), length = 1;
+            for (uint32_t next = follow(cell, dir); next != cell; next = follow(cell, dir)) {
+                cell = next;
+                length++;
+                if (cell == current) break;
+            }
+            if (cell == current) continue; // the corridor loops back
+            uint32_t new_g_score = g_scores[current] + length;
+            if (!reached(cell) || new_g_score < g_scores[cell]) {
+                epochs[cell] = epoch;
+                predecessors[cell] = current;
+                jump_directions[cell] = (uint8_t) i;
+                g_scores[cell] = new_g_score;
+                double f_score = new_g_score + a_star_heuristic(cell % width, cell / width, endX, endY, heuristic);
+                discovered.push_or_decrease(cell, key{f_score, new_g_score});
+            }
+        }
     }
-    cerr << "No path found!\n";
     return false;
 }
+
+template <class Maze>
+bool PathSearchContext<Maze>::find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+    MazePath& path, string heuristic, string search) {
+    bool found = find_path(startX, startY, endX, endY, cell_path, heuristic, search);
+    if (!path.assign(cell_path, width)) {
+        cerr << "ERROR: path cells are not neighbors!\n";
+        return false;
+    }
+    return found;
+}
+
+template class PathSearchContext<MazeGrid>;
+template class PathSearchContext<PackedMaze>;
+
+template <class Maze>
+PathQueryEngine<Maze>::PathQueryEngine(const Maze& maze, size_t threads)
+    : maze(&maze), pool(new work_stealing_pool(threads)) {
+    for (size_t i = 0; i < pool->size(); ++i)
+        contexts.push_back(unique_ptr<PathSearchContext<Maze>>(new PathSearchContext<Maze>(maze)));
+}
+
+/**
+ * One task per worker, each taking small chunks of queries off a shared
+ * counter so that slow queries do not leave the other workers idle
+ */
+template <class Maze>
+void PathQueryEngine<Maze>::find_paths(const vector<PathQuery>& queries, vector<PathQueryResult>& results,
+    string heuristic, string search) {
+    const size_t chunk = 16;
+    results.resize(queries.size());
+    std::atomic<size_t> next(0);
+    for (size_t t = 0; t < contexts.size(); ++t) {
+        PathSearchContext<Maze>* context = contexts[t].get();
+        pool->submit([&queries, &results, &next, &heuristic, &search, context, chunk]() {
+            for (size_t first = next.fetch_add(chunk); first < queries.size(); first = next.fetch_add(chunk)) {
+                size_t last = std::min(first + chunk, queries.size());
+                for (size_t i = first; i < last; ++i) {
+                    const PathQuery& query = queries[i];
+                    auto start = std::chrono::steady_clock::now();
+                    context->find_path(query.startX, query.startY, query.endX, query.endY,
+                        results[i].path, heuristic, search);
+                    auto stop = std::chrono::steady_clock::now();
+                    results[i].expanded = context->expanded();
+                    results[i].latency_ns = (uint64_t)
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+                }
+            }
+        });
+    }
+    pool->wait();
+}
+
+template class PathQueryEngine<MazeGrid>;
+template class PathQueryEngine<PackedMaze>;
+
+/**
+ * Solves maze using A* algorithm
+ * Coordinates are wrt the number of cells (input to generate_maze)
+ * The path is marked on the grid with 2, the start with 3, the end with 4
+ * and visited cells with 5
+ * 
+ * @param heuristic heuristic to use (manhattan, euclidean)
+ */ 
+bool a_star(MazeGrid& grid, size_t startX, size_t startY, size_t endX, size_t endY,
+    string heuristic, bool track_visited) {
+    size_t width = grid.cell_width(), height = grid.cell_height();
+    vector<size_t> path;
+    PathSearchContext<MazeGrid> context(grid);
+    if (!context.find_path(startX, startY, endX, endY, path, heuristic)) return false;
+    // mark visited cells and the walls to their predecessors if applicable
+    for (size_t cell = 0; track_visited && cell < width * height; ++cell) {
+        size_t previous = context.visited(cell) ? context.predecessor(cell) : cell;
+        if (previous == cell) continue;
+        size_t gridX = 2 * (cell % width) + 1, gridY = 2 * (cell / width) + 1;
+        size_t prevX = 2 * (previous % width) + 1, prevY = 2 * (previous / width) + 1;
+        grid(gridX, gridY) = 5;
+        grid((gridX + prevX) / 2, (gridY + prevY) / 2) = 5;
+    }
+    for (size_t i = 1; i < path.size(); ++i) {
+        size_t gridX = 2 * (path[i] % width) + 1, gridY = 2 * (path[i] / width) + 1;
+        size_t prevX = 2 * (path[i-1] % width) + 1, prevY = 2 * (path[i-1] / width) + 1;
+        grid(gridX, gridY) = 2;
+        grid((gridX + prevX) / 2, (gridY + prevY) / 2) = 2;
+    }
+    grid(2*startX+1, 2*startY+1) = 3;
+    grid(2*endX+1, 2*endY+1) = 4;
+    return true;
+}
+
+/**
+ * Solves a packed maze using A* without expanding it to the full grid
+ * Allocates a new search context, use a PathSearchContext directly for repeated queries
+ * 
+ * @param path filled with the cell indices (y * width + x) from start to end
+ * @param expanded if given, set to the number of cells expanded by the search
+ * @param search search to run (a-star, bidirectional, corridor)
+ */
+bool a_star(const PackedMaze& maze, size_t startX, size_t startY, size_t endX, size_t endY,
+    vector<size_t>& path, string heuristic, size_t* expanded, string search) {
+    PathSearchContext<PackedMaze> context(maze);
+    bool found = context.find_path(startX, startY, endX, endY, path, heuristic, search);
+    if (expanded) *expanded = context.expanded();
+    return found;
+}
+
+bool a_star(vector<vector<int>>& grid, size_t startX, size_t startY, size_t endX, size_t endY,
+    string heuristic, bool track_visited) {
+    MazeGrid flat(grid);
+    bool found = a_star(flat, startX, startY, endX, endY, heuristic, track_visited);
+    flat.copy_to(grid);
+    return found;
+}
@@ -2,16 +2,41 @@
 #include <vector>
 #include <memory>
 
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+#include "../maze_generator/terminal_renderer.h"
+#include "path_search_context.h"
+
 using std::unique_ptr;
 using std::string;
 using std::vector;
 
 
+void display_path(const MazeGrid& grid, bool colors=false, bool visited=false);
+
+void save_path(const MazeGrid& grid, string file_path);
+
+unique_ptr<MazeGrid> load_path(string file_path);
+
+// compact paths, the maze is left unchanged
+void display_path(const MazeGrid& grid, const MazePath& path, bool colors=false);
+
+void display_path(const PackedMaze& maze, const MazePath& path, bool colors=false);
+
+void save_path(const MazePath& path, string file_path);
+
+unique_ptr<MazePath> load_compact_path(string file_path);
+
+bool a_star(MazeGrid& grid, size_t startX, size_t startY, size_t endX, size_t endY,
+    string heuristic="manhattan", bool track_visited=true);
+
+bool a_star(const PackedMaze& maze, size_t startX, size_t startY, size_t endX, size_t endY,
+    vector<size_t>& path, string heuristic="manhattan", size_t* expanded=nullptr, string search="a-star");
+
+// adapters for the legacy column-major nested vector grid
 void display_path(vector<vector<int>>& grid, bool colors=false, bool visited=false);
 
 void save_path(vector<vector<int>>& grid, string file_path);
 
-unique_ptr<vector<vector<int>>> load_path(string file_path);
-
 bool a_star(vector<vector<int>>& grid, size_t startX, size_t startY, size_t endX, size_t endY,
     string heuristic="manhattan", bool track_visited=true);
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef PATH_SEARCH_CONTEXT_H
+#define PATH_SEARCH_CONTEXT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "indexed_heap.h"
+#include "maze_path.h"
+#include "../maze_generator/threading.h"
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+#include "../maze_generator/maze_walk.h"
+
+using std::string;
+using std::vector;
+using std::size_t;
+using std::uint32_t;
+using std::uint64_t;
+using std::unique_ptr;
+
+// heuristic index of a heuristic name (manhattan, euclidean, none)
+int parse_heuristic(string heuristic);
+
+// heuristic distance from a cell to the goal for a heuristic index
+double a_star_heuristic(size_t x, size_t y, size_t goalX, size_t goalY, int heuristic);
+
+/**
+ * Reusable A* state bound to one maze
+ * The score, predecessor and heap buffers are kept between queries and reset
+ * lazily: each cell records the epoch of the query that last wrote it, so
+ * starting a query only advances the epoch and a query touches only the
+ * cells it reaches
+ *
+ * The maze is only read, so several contexts (e.g. one per thread) can share it
+ * Defined for MazeGrid and PackedMaze
+ */
+template <class Maze>
+class PathSearchContext {
+    public:
+        /**
+         * Heap key of a discovered cell, ordered by f score
+         * Ties prefer the larger g score, i.e. the cell closer to the goal
+         */
+        struct key {
+            double f_score;
+            uint32_t g_score;
+            bool operator<(const key& other) const {
+                return f_score < other.f_score || (f_score == other.f_score && g_score > other.g_score);
+            }
+        };
+    private:
+        const Maze* maze;
+        size_t width;
+        size_t height;
+        uint32_t epoch; // current query, cells with an older epoch are unreached
+        vector<uint32_t> epochs;
+        vector<uint32_t> g_scores;
+        vector<uint32_t> predecessors;
+        indexed_heap<key> discovered;
+        // the backward half of the bidirectional search
+        vector<uint32_t> backward_epochs;
+        vector<uint32_t> backward_g_scores;
+        vector<uint32_t> backward_predecessors;
+        indexed_heap<key> backward_discovered;
+        vector<uint8_t> jump_directions; // corridor search: direction each jump left its predecessor in
+        size_t expanded_cells;
+        vector<size_t> cell_path; // scratch for the compact find_path
+
+        bool reached(uint32_t cell) const { return epochs[cell] == epoch; }
+        void next_epoch();
+        bool search_forward(uint32_t start, uint32_t end, int heuristic, vector<size_t>& path);
+        bool search_bidirectional(uint32_t start, uint32_t end, int heuristic, vector<size_t>& path);
+        bool search_corridors(uint32_t start, uint32_t end, int heuristic, vector<size_t>& path);
+    public:
+        explicit PathSearchContext(const Maze& maze);
+
+        /**
+         * Bind to another maze, keeping the buffers if they are large enough
+         */
+        void bind(const Maze& maze);
+        const Maze& get_maze() const { return *maze; }
+
+        /**
+         * Find a shortest path
+         * Coordinates are wrt the number of cells
+         *
+         * @param path filled with the cell indices (y * width + x) from start to end
+         * @param heuristic heuristic to use (manhattan, euclidean, none)
+         * @param search a-star searches forward from the start,
+         *               bidirectional searches from both ends until they meet,
+         *               corridor jumps along corridors and only expands junctions
+         * @return whether a path was found
+         */
+        bool find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+            vector<size_t>& path, string heuristic="manhattan", string search="a-star");
+        /**
+         * Find a shortest path and store it compactly
+         * The path is left empty if there is none
+         */
+        bool find_path(size_t startX, size_t startY, size_t endX, size_t endY,
+            MazePath& path, string heuristic="manhattan", string search="a-star");
+
+        // number of cells expanded by the last query, junctions only for the corridor search
+        size_t expanded() const { return expanded_cells; }
+        // whether a cell was given a score by the forward half of the last query
+        bool visited(size_t cell) const { return reached((uint32_t) cell); }
+        /**
+         * Preceding cell on the best known forward path to a visited cell
+         * The start is its own predecessor; after a corridor search this is the previous junction
+         */
+        size_t predecessor(size_t cell) const { return predecessors[cell]; }
+};
+
+/**
+ * Endpoints of one path query, in cell coordinates
+ */
+struct PathQuery {
+    size_t startX;
+    size_t startY;
+    size_t endX;
+    size_t endY;
+};
+
+struct PathQueryResult {
+    MazePath path; // empty if there is no path
+    size_t expanded; // cells expanded by the search
+    uint64_t latency_ns; // time spent on this query by its worker
+};
+
+/**
+ * Answers batches of path queries against one maze with a pool of workers
+ * The maze is shared read-only and every task slot keeps its own
+ * PathSearchContext, so the workers never write to shared state except their
+ * own results
+ * Defined for MazeGrid and PackedMaze
+ */
+template <class Maze>
+class PathQueryEngine {
+    private:
+        const Maze* maze;
+        unique_ptr<work_stealing_pool> pool;
+        vector<unique_ptr<PathSearchContext<Maze>>> contexts; // one per worker
+    public:
+        /**
+         * @param threads number of workers, 0 for one per hardware thread
+         */
+        explicit PathQueryEngine(const Maze& maze, size_t threads=0);
+
+        size_t threads() const { return contexts.size(); }
+
+        /**
+         * Answer every query, blocking until all are done
+         *
+         * @param results resized to one entry per query, in query order
+         */
+        void find_paths(const vector<PathQuery>& queries, vector<PathQueryResult>& results,
+            string heuristic="manhattan", string search="a-star");
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include "tree_index.h"
+#include "../maze_generator/maze_walk.h"
+
+using std::cerr;
+
+/**
+ * Root the maze at cell 0 and number it in depth-first preorder with an explicit stack
+ * A cell is marked when it is pushed, so reaching a marked cell other than the
+ * parent means the maze has a loop
+ */
+template <class Maze>
+bool MazeTreeIndex::build(const Maze& maze) {
+    const uint32_t unvisited = std::numeric_limits<uint32_t>::max();
+    size_t width = maze.cell_width(), height = maze.cell_height();
+    ptrdiff_t neighbor_offsets[] = {-1, -(ptrdiff_t) width, 1, (ptrdiff_t) width}; // index offsets
+    maze_width = width;
+    parents.assign(width * height, unvisited);
+    preorder.assign(width * height, 0);
+    order.assign(width * height, 0);
+    depths.assign(width * height, 0);
+
+    vector<uint32_t> stack(1, 0), cell_depths(width * height, 0);
+    parents[0] = 0;
+    uint32_t position = 0;
+    while (!stack.empty()) {
+        uint32_t current = stack.back();
+        stack.pop_back();
+        preorder[current] = position;
+        order[position] = current;
+        depths[position++] = cell_depths[current];
+        size_t x = current % width, y = current / width;
+        for (int i = 0; i < 4; ++i) {
+            if (!has_opening(maze, x, y, (Direction) i)) continue;
+            uint32_t neighbor = (uint32_t) (current + neighbor_offsets[i]);
+            if (neighbor == parents[current]) continue;
+            if (parents[neighbor] != unvisited) return false; // loop
+            parents[neighbor] = current;
+            cell_depths[neighbor] = cell_depths[current] + 1;
+            stack.push_back(neighbor);
+        }
+    }
+    return position == width * height; // otherwise some cells are unreachable
+}
+
+/**
+ * Stack masks inside each block and the sparse table over block minima
+ * Bit j of masks[i] is set if position (block start + j) is on the stack of
+ * increasing depths after pushing position i, so the minimum of a range
+ * inside a block is the lowest stacked position at or after its start
+ */
+void MazeTreeIndex::build_range_minimum() {
+    size_t n = depths.size(), blocks = (n + block_size - 1) / block_size;
+    masks.assign(n, 0);
+    block_table.assign(1, vector<uint32_t>(blocks));
+    for (size_t b = 0; b < blocks; ++b) {
+        size_t first = b * block_size, last = std::min(first + block_size, n);
+        uint32_t mask = 0;
+        for (size_t i = first; i < last; ++i) {
+            while (mask != 0 && depths[first + 31 - __builtin_clz(mask)] > depths[i])
+                mask &= ~((uint32_t) 1 << (31 - __builtin_clz(mask)));
+            mask |= (uint32_t) 1 << (i - first);
+            masks[i] = mask;
+        }
+        block_table[0][b] = (uint32_t) (first + __builtin_ctz(masks[last - 1]));
+    }
+    for (size_t k = 1; ((size_t) 1 << k) <= blocks; ++k) {
+        const vector<uint32_t>& previous = block_table[k - 1];
+        vector<uint32_t> level(blocks - ((size_t) 1 << k) + 1);
+        for (size_t b = 0; b < level.size(); ++b)
+            level[b] = shallower(previous[b], previous[b + ((size_t) 1 << (k - 1))]);
+        block_table.push_back(level);
+    }
+}
+
+template <class Maze>
+unique_ptr<MazeTreeIndex> MazeTreeIndex::create(const Maze& maze) {
+    if (maze.cell_width() * maze.cell_height() >= (size_t) std::numeric_limits<uint32_t>::max()) {
+        cerr << "ERROR: maze is too large for 32-bit cell indices!\n";
+        return unique_ptr<MazeTreeIndex>();
+    }
+    if (maze.empty()) return unique_ptr<MazeTreeIndex>();
+    unique_ptr<MazeTreeIndex> index{new MazeTreeIndex()};
+    if (!index->build(maze)) {
+        cerr << "ERROR: maze is not a perfect maze!\n";
+        return unique_ptr<MazeTreeIndex>();
+    }
+    index->build_range_minimum();
+    return index;
+}
+
+// position of the shallowest cell in preorder positions first..last of one block
+uint32_t MazeTreeIndex::block_minimum(size_t first, size_t last) const {
+    size_t start = first - first % block_size;
+    return (uint32_t) (start + __builtin_ctz(masks[last] & (~(uint32_t) 0 << (first - start))));
+}
+
+// position of the shallowest cell in preorder positions first..last
+uint32_t MazeTreeIndex::range_minimum(size_t first, size_t last) const {
+    size_t first_block = first / block_size, last_block = last / block_size;
+    if (first_block == last_block) return block_minimum(first, last);
+    uint32_t minimum = shallower(block_minimum(first, first_block * block_size + block_size - 1),
+        block_minimum(last_block * block_size, last));
+    if (last_block - first_block > 1) {
+        size_t from = first_block + 1, to = last_block - 1;
+        size_t k = 31 - __builtin_clz((uint32_t) (to - from + 1));
+        minimum = shallower(minimum, shallower(block_table[k][from], block_table[k][to + 1 - ((size_t) 1 << k)]));
+    }
+    return minimum;
+}
+
+size_t MazeTreeIndex::lowest_common_ancestor(size_t a, size_t b) const {
+    if (a == b) return a;
+    size_t first = std::min(preorder[a], preorder[b]) + 1, last = std::max(preorder[a], preorder[b]);
+    return parents[order[range_minimum(first, last)]];
+}
+
+void MazeTreeIndex::path(size_t a, size_t b, vector<size_t>& cells) const {
+    size_t ancestor = lowest_common_ancestor(a, b);
+    cells.clear();
+    for (; a != ancestor; a = parents[a]) cells.push_back(a);
+    size_t middle = cells.size();
+    for (; b != ancestor; b = parents[b]) cells.push_back(b);
+    cells.push_back(ancestor);
+    std::reverse(cells.begin() + middle, cells.end());
+}
+
+void MazeTreeIndex::path(size_t a, size_t b, MazePath& path) const {
+    vector<size_t> cells;
+    this->path(a, b, cells);
+    if (!path.assign(cells, maze_width)) cerr << "ERROR: path cells are not neighbors!\n";
+}
+
+size_t MazeTreeIndex::bytes() const {
+    size_t total = (parents.size() + preorder.size() + order.size() + depths.size() + masks.size())
+        * sizeof(uint32_t);
+    for (const vector<uint32_t>& level : block_table) total += level.size() * sizeof(uint32_t);
+    return total;
+}
+
+template unique_ptr<MazeTreeIndex> MazeTreeIndex::create(const MazeGrid&);
+template unique_ptr<MazeTreeIndex> MazeTreeIndex::create(const PackedMaze&);
@@ -0,0 +1,82 @@
+#ifndef TREE_INDEX_H
+#define TREE_INDEX_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "maze_path.h"
+#include "../maze_generator/maze_grid.h"
+#include "../maze_generator/packed_maze.h"
+
+using std::vector;
+using std::size_t;
+using std::uint32_t;
+using std::unique_ptr;
+
+/**
+ * Lowest common ancestor index over a perfect maze
+ * A perfect maze is a spanning tree of its cells, so the only path between
+ * two cells goes through their lowest common ancestor once the tree is rooted.
+ * The tree is rooted at cell 0 and numbered in depth-first preorder, then the
+ * ancestor of a and b is the parent of the shallowest cell in the preorder
+ * range (a, b]. That range minimum is answered in O(1) by a sparse table over
+ * blocks of 32 cells plus a 32-bit stack mask per cell inside a block.
+ *
+ * Distances are O(1) and paths O(path length), without any search.
+ * Cell indices are y * width + x.
+ */
+class MazeTreeIndex {
+    private:
+        static const size_t block_size = 32;
+
+        size_t maze_width;
+        vector<uint32_t> parents; // by cell, the root is its own parent
+        vector<uint32_t> preorder; // preorder position of each cell
+        vector<uint32_t> order; // cell at each preorder position
+        vector<uint32_t> depths; // depth of the cell at each preorder position
+        vector<uint32_t> masks; // in-block minimum stack at each preorder position
+        vector<vector<uint32_t>> block_table; // block_table[k][b] = position of the minimum of blocks b..b+2^k-1
+
+        MazeTreeIndex() : maze_width(0) {}
+        template <class Maze>
+        bool build(const Maze& maze);
+        void build_range_minimum();
+        uint32_t shallower(uint32_t a, uint32_t b) const { return depths[b] < depths[a] ? b : a; }
+        uint32_t block_minimum(size_t first, size_t last) const;
+        uint32_t range_minimum(size_t first, size_t last) const;
+    public:
+        /**
+         * Build the index for a maze
+         * Defined for MazeGrid and PackedMaze
+         *
+         * @return empty if the maze is not a perfect maze (has loops or unreachable cells)
+         */
+        template <class Maze>
+        static unique_ptr<MazeTreeIndex> create(const Maze& maze);
+
+        size_t width() const { return maze_width; }
+        size_t cells() const { return parents.size(); }
+        size_t cell(size_t x, size_t y) const { return y * maze_width + x; }
+
+        size_t parent(size_t cell) const { return parents[cell]; }
+        size_t depth(size_t cell) const { return depths[preorder[cell]]; }
+        size_t lowest_common_ancestor(size_t a, size_t b) const;
+        /**
+         * Number of steps on the path between two cells
+         */
+        size_t distance(size_t a, size_t b) const {
+            return depth(a) + depth(b) - 2 * depth(lowest_common_ancestor(a, b));
+        }
+        /**
+         * Path from a to b, walking up from both ends to their common ancestor
+         */
+        void path(size_t a, size_t b, vector<size_t>& cells) const;
+        void path(size_t a, size_t b, MazePath& path) const;
+
+        // bytes used by the index
+        size_t bytes() const;
+};
+
+#endif